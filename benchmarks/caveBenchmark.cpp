@@ -0,0 +1,90 @@
+// Chunk generation with and without the cave stage, on a fixed seed and chunk set. Prints the
+// time per chunk of each stage and how much of the generation time caves add, and fails if
+// that is over the budget.
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include "../src/core/options.hpp"
+#include "../src/world/blockDB.hpp"
+#include "../src/world/structureDB.hpp"
+#include "../src/world/world.hpp"
+
+static const int SEED = 1234;
+static const int RADIUS = 12; // 25x25 chunks around the origin
+static const int PASSES = 5;
+// Caves may make generation at most this much slower, as a fraction of generation without them
+static const double ADDED_BUDGET = 0.6;
+
+struct PassResult {
+    double totalMs = 0.0; // Wall time per chunk
+    Chunk::GenerationTimes stages; // Per chunk
+};
+
+// Generates every chunk of the set once, on this thread
+static PassResult generatePass(World& world) {
+    PassResult result;
+    int chunkCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int x = -RADIUS; x <= RADIUS; ++x) {
+        for (int z = -RADIUS; z <= RADIUS; ++z) {
+            std::unique_ptr<Chunk> chunk(new Chunk(x, z, &world));
+            result.stages.terrainMs += chunk->generationTimes.terrainMs;
+            result.stages.cavesMs += chunk->generationTimes.cavesMs;
+            result.stages.featuresMs += chunk->generationTimes.featuresMs;
+            chunkCount++;
+        }
+    }
+    result.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / chunkCount;
+    result.stages.terrainMs /= chunkCount;
+    result.stages.cavesMs /= chunkCount;
+    result.stages.featuresMs /= chunkCount;
+    return result;
+}
+
+static void printResult(const char* name, const PassResult& result) {
+    std::printf("%-10s %8.4f %8.4f %8.4f %8.4f\n", name, result.totalMs, result.stages.terrainMs,
+                result.stages.cavesMs, result.stages.featuresMs);
+}
+
+int main() {
+    BlockDB::initialize();
+    StructureDB::initialize();
+
+    // The generator takes its settings from the options when the world is created
+    setOptionInt("world_seed", SEED);
+    setOptionInt("caves", 0);
+    World withoutCaves;
+    setOptionInt("caves", 1);
+    World withCaves;
+
+    // First pass fills the column caches, then the fastest of the timed passes counts.
+    // The two worlds take turns so both see the same machine state.
+    generatePass(withoutCaves);
+    generatePass(withCaves);
+    PassResult bestWithout, bestWith;
+    for (int pass = 0; pass < PASSES; ++pass) {
+        PassResult without = generatePass(withoutCaves);
+        PassResult with = generatePass(withCaves);
+        if (pass == 0 || without.totalMs < bestWithout.totalMs) bestWithout = without;
+        if (pass == 0 || with.totalMs < bestWith.totalMs) bestWith = with;
+    }
+
+    int side = RADIUS * 2 + 1;
+    std::printf("Seed %d, %dx%d chunks, %s noise, fastest of %d passes\n\n", SEED, side, side,
+                getNoiseSimdName(withCaves.getGenerator().noises.baseNoise.getSimd()), PASSES);
+    std::printf("ms/chunk      total  terrain    caves features\n");
+    printResult("caves=0", bestWithout);
+    printResult("caves=1", bestWith);
+
+    double added = bestWith.totalMs - bestWithout.totalMs;
+    std::printf("\nCaves add %.4f ms per chunk: %.0f%% of generation with caves, +%.0f%% over generation without\n",
+                added, 100.0 * added / bestWith.totalMs, 100.0 * added / bestWithout.totalMs);
+    std::printf("Cave stage alone (sampling and carving): %.0f%% of generation with caves\n",
+                100.0 * bestWith.stages.cavesMs / bestWith.totalMs);
+
+    if (added > bestWithout.totalMs * ADDED_BUDGET) {
+        std::printf("FAIL caves add more than the +%.0f%% budget\n", 100.0 * ADDED_BUDGET);
+        return 1;
+    }
+    return 0;
+}
@@ -1,24 +1,47 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
-layout (location = 2) in float aFaceID;
+// PackedVertex (see chunkMesher.hpp):
+//   x: x | y << 5 | z << 10 | face << 15 | corner << 18 | atlas tile << 20
+//   y: quad width | quad height << 5
+layout (location = 0) in uvec2 aPacked;
 
 out vec2 TexCoord;
-out float FaceID;
+flat out vec2 Tile;
+flat out float Brightness;
 out float fogFactor;
 
-uniform mat4 model;
+// Origin of the section a vertex belongs to, one per VertexArena page of 64 vertices
+uniform isamplerBuffer sectionOrigins;
 uniform mat4 view;
 uniform mat4 projection;
 
 uniform float fogStartDistance;
 uniform float fogDensity;
 
+const vec2 cornerUVs[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+const float faceBrightness[6] = float[6](
+    0.90, // Front
+    0.90, // Back
+    0.80, // Left
+    0.80, // Right
+    1.00, // Top
+    0.75  // Bottom
+);
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    TexCoord = aTexCoord;
-    FaceID = aFaceID;
+    vec3 pos = vec3(aPacked.x & 31u, (aPacked.x >> 5) & 31u, (aPacked.x >> 10) & 31u);
+    uint face = (aPacked.x >> 15) & 7u;
+    uint corner = (aPacked.x >> 18) & 3u;
+    uint tile = (aPacked.x >> 20) & 255u;
+    vec2 quadSize = vec2(aPacked.y & 31u, (aPacked.y >> 5) & 31u);
+
+    // gl_VertexID includes the draw's base vertex, so it's the vertex's index in the arena
+    vec3 origin = vec3(texelFetch(sectionOrigins, gl_VertexID / 64).xyz);
+
+    gl_Position = projection * view * vec4(origin + pos, 1.0);
+    TexCoord = cornerUVs[corner] * quadSize;
+    Tile = vec2(tile & 15u, tile >> 4);
+    Brightness = faceBrightness[face];
     
     float distance = length(gl_Position.xyz);
     float adjustedDistance = max(0.0, distance - fogStartDistance);
@@ -133,6 +133,14 @@ void processInput(GLFWwindow* window, Camera& camera, float deltaTime, float spe
     }
     fPressedLastFrame = fPressedThisFrame;
 
+    // Toggle between greedy and per-face meshing with G key
+    static bool gPressedLastFrame = false;
+    bool gPressedThisFrame = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+    if (gPressedThisFrame && !gPressedLastFrame && g_world) {
+        g_world->toggleMeshingMode();
+    }
+    gPressedLastFrame = gPressedThisFrame;
+
     // Block selection with number keys 1-9
     for (int i = 1; i <= 9; ++i) {
         if (glfwGetKey(window, GLFW_KEY_1 + (i - 1)) == GLFW_PRESS) {
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include "jobSystem.hpp"
+
+JobSystem::JobSystem(unsigned int threadCount)
+    : running(true), queuedJobs(0), nextQueue(0)
+{
+    if (threadCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+void JobSystem::WorkerQueue::grow(size_t size) {
+    std::vector<Job> grown(size);
+    for (size_t i = 0; i < count; ++i) {
+        grown[i] = std::move(ring[(head + i) % ring.size()]);
+    }
+    ring.swap(grown);
+    head = 0;
+}
+
+void JobSystem::WorkerQueue::pushBack(Job&& job) {
+    if (count == ring.size()) {
+        grow(ring.empty() ? 64 : ring.size() * 2);
+    }
+    ring[(head + count) % ring.size()] = std::move(job);
+    ++count;
+}
+
+JobSystem::Job JobSystem::WorkerQueue::popFront() {
+    Job job = std::move(ring[head]);
+    ring[head] = nullptr;
+    head = (head + 1) % ring.size();
+    --count;
+    return job;
+}
+
+JobSystem::Job JobSystem::WorkerQueue::popBack() {
+    size_t back = (head + count - 1) % ring.size();
+    Job job = std::move(ring[back]);
+    ring[back] = nullptr;
+    --count;
+    return job;
+}
+
+void JobSystem::WorkerQueue::clear() {
+    for (size_t i = 0; i < count; ++i) {
+        ring[(head + i) % ring.size()] = nullptr;
+    }
+    head = 0;
+    count = 0;
+}
+
+void JobSystem::submit(Job job) {
+    // Spread jobs over the workers, idle ones will steal the rest
+    unsigned int index = nextQueue.fetch_add(1) % queues.size();
+    {
+        // Count before pushing so a worker never sees the job without it being counted
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->pushBack(std::move(job));
+    }
+    wakeCondition.notify_one();
+}
+
+void JobSystem::reserve(size_t jobCount) {
+    for (auto& queue : queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->ring.size() < jobCount) {
+            queue->grow(std::max(jobCount, queue->ring.size() * 2));
+        }
+    }
+}
+
+void JobSystem::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (!running) return;
+        running = false;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+    for (auto& queue : queues) {
+        queue->clear();
+    }
+    queuedJobs = 0;
+}
+
+bool JobSystem::popJob(unsigned int index, Job& job) {
+    // Own queue first
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.empty()) {
+            job = own.popFront();
+            return true;
+        }
+    }
+
+    // Steal from the other workers
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkerQueue& victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.empty()) {
+            job = victim.popBack();
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+    while (true) {
+        Job job;
+        if (popJob(index, job)) {
+            queuedJobs.fetch_sub(1);
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this] { return !running || queuedJobs.load() > 0; });
+        if (!running) return;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker pool with one job deque per thread. Workers take jobs from the front of their
+// own deque (so jobs run roughly in submission order) and steal from the back of the
+// other deques when they run dry.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    // threadCount = 0 picks one worker per hardware thread, minus the main thread
+    explicit JobSystem(unsigned int threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(Job job);
+    // Grows every worker's queue to hold this many jobs, so submitting up to that many at once
+    // never allocates however the workers happen to keep up
+    void reserve(size_t jobCount);
+
+    // Stops the workers after their current job, queued jobs are dropped
+    void shutdown();
+
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(threads.size()); }
+    size_t getQueuedCount() const { return queuedJobs.load(); }
+
+private:
+    // Growable ring buffer of jobs. Unlike std::deque it keeps its storage, so submitting
+    // doesn't allocate once it has grown to the usual backlog.
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<Job> ring;
+        size_t head = 0; // Front job
+        size_t count = 0;
+
+        bool empty() const { return count == 0; }
+        // Moves the jobs front first into a ring of the given size
+        void grow(size_t size);
+        void pushBack(Job&& job);
+        Job popFront();
+        Job popBack();
+        void clear();
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> running;
+    std::atomic<size_t> queuedJobs;
+    std::atomic<unsigned int> nextQueue;
+
+    void workerLoop(unsigned int index);
+    bool popJob(unsigned int index, Job& job);
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Multi-producer, single-consumer queue. Producers push with a CAS loop, the consumer
+// takes the whole list at once with a single exchange (so there is no ABA problem) and
+// gets the items back in push order.
+template <typename T>
+class LockFreeQueue {
+public:
+    LockFreeQueue() : head(nullptr) {}
+
+    ~LockFreeQueue() {
+        Node* node = head.exchange(nullptr);
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node,
+                                           std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // Consumer only: appends every queued item to out, oldest first
+    void popAll(std::vector<T>& out) {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+
+        // The list is newest first, reverse it
+        Node* reversed = nullptr;
+        while (node) {
+            Node* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+
+        while (reversed) {
+            Node* next = reversed->next;
+            out.push_back(std::move(reversed->value));
+            delete reversed;
+            reversed = next;
+        }
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> head;
+};
+
+// Same queue for objects that carry their own T* next, so pushing never allocates.
+// An object must not be pushed again before the consumer has popped it.
+template <typename T>
+class IntrusiveLockFreeQueue {
+public:
+    IntrusiveLockFreeQueue() : head(nullptr) {}
+
+    IntrusiveLockFreeQueue(const IntrusiveLockFreeQueue&) = delete;
+    IntrusiveLockFreeQueue& operator=(const IntrusiveLockFreeQueue&) = delete;
+
+    void push(T* item) {
+        item->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(item->next, item,
+                                           std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // Consumer only: appends every queued item to out, oldest first
+    void popAll(std::vector<T*>& out) {
+        T* item = head.exchange(nullptr, std::memory_order_acquire);
+
+        // The list is newest first, reverse it
+        T* reversed = nullptr;
+        while (item) {
+            T* next = item->next;
+            item->next = reversed;
+            reversed = item;
+            item = next;
+        }
+
+        for (; reversed; reversed = reversed->next) {
+            out.push_back(reversed);
+        }
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    std::atomic<T*> head;
+};
@@ -39,3 +39,8 @@ float getOptionFloat(const std::string& key, const float defaultValue) {
     if (it != optionsMap.end()) return static_cast<float>(it->second);
     return defaultValue;
 }
+
+void setOptionInt(const std::string& key, int value) {
+    if (!loaded) loadOptionsFromFile("options.txt");
+    optionsMap[key] = value;
+}
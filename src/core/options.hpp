@@ -4,4 +4,5 @@
 
 void loadOptionsFromFile(const std::string& filename);
 int getOptionInt(const std::string& key, int defaultValue);
-float getOptionFloat(const std::string& key, float defaultValue);
\ No newline at end of file
+float getOptionFloat(const std::string& key, float defaultValue);
+void setOptionInt(const std::string& key, int value); // Runtime only, not written back to the file
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <glad/glad.h>
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
@@ -5,7 +6,10 @@
 #include <string>
 #include "ImGuiOverlay.hpp"
 #include "../world/block_interaction.hpp"
+#include "../world/world.hpp"
+#include "../world/chunkMesher.hpp"
 #include "../core/input.hpp"
+#include "../core/options.hpp"
 #include <vector>
 
 std::map<uint8_t, std::string> blockNames = {
@@ -58,7 +62,7 @@ void ImGuiOverlay::render(float deltaTime, const Camera& camera, World* world) {
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    ImGui::SetNextWindowSize(ImVec2(285, 190)); // Width: 285, Height: 190
+    ImGui::SetNextWindowSize(ImVec2(300, 500)); // Width: 300, Height: 500
     
     glm::vec3 pos = camera.getPosition();
     glm::vec3 front = camera.getFront();
@@ -84,6 +88,50 @@ void ImGuiOverlay::render(float deltaTime, const Camera& camera, World* world) {
         ImGui::Text("Block position: undefined");
     }
 
+    World::MeshStats meshStats = world->getMeshStats();
+    ImGui::Text("Chunks: %d loaded, %d generating", meshStats.chunkCount, world->getChunksInFlight());
+    ImGui::Text("Meshes in flight: %d, sorts in flight: %d", world->getMeshesInFlight(), world->getSortsInFlight());
+    ImGui::Text("Block storage: %.1f MiB (%.1f MiB unpacked)",
+                world->getBlockMemoryUsage() / (1024.0f * 1024.0f),
+                meshStats.chunkCount * (Chunk::WIDTH * Chunk::HEIGHT * Chunk::DEPTH) / (1024.0f * 1024.0f));
+    ImGui::Text("Noise kernels: %s", getNoiseSimdName(world->getGenerator().noises.baseNoise.getSimd()));
+    ImGui::Text("Column cache: %d tiles, %.0f%% hits", world->getColumnCache().getTileCount(), world->getColumnCache().getHitRate() * 100.0f);
+
+    // Average per chunk, caves should stay a small part of the total
+    World::GenerationStats genStats = world->getGenerationStats();
+    float genChunks = genStats.chunkCount ? static_cast<float>(genStats.chunkCount) : 1.0f;
+    const Chunk::GenerationTimes& genTimes = genStats.totalTimes;
+    ImGui::Text("Avg gen time: %.3f ms", (genTimes.terrainMs + genTimes.cavesMs + genTimes.featuresMs) / genChunks);
+    ImGui::Text("  terrain %.3f, caves %.3f, features %.3f",
+                genTimes.terrainMs / genChunks, genTimes.cavesMs / genChunks, genTimes.featuresMs / genChunks);
+    ImGui::Text("Mesher: %s (G to toggle)", Chunk::meshingMode == Chunk::MeshingMode::Greedy ? "greedy" : "per-face");
+    ImGui::Text("Vertices: %zu (%.1f MiB)", meshStats.vertexCount,
+                meshStats.vertexCount * sizeof(PackedVertex) / (1024.0f * 1024.0f));
+    ImGui::Text("Avg mesh time: %.3f ms", meshStats.chunkCount ? meshStats.totalMeshTimeMs / meshStats.chunkCount : 0.0f);
+    World::SortStats sortStats = world->getSortStats();
+    ImGui::Text("Translucent sort: %.3f ms/frame (%.1f sections)", sortStats.frameMs, sortStats.sectionsPerFrame);
+    World::DrawStats drawStats = world->getDrawStats();
+    ImGui::Text("Draw calls: %d (%d sections)", drawStats.drawCalls, drawStats.sections);
+
+    // Fragmentation: how much of the free space is outside the largest free range
+    VertexArena::Stats arenaStats = world->getVertexArena().getStats();
+    const float mib = sizeof(PackedVertex) / (1024.0f * 1024.0f);
+    ImGui::Text("Vertex arena: %.1f / %.1f MiB (at most %.1f)", arenaStats.used * mib, arenaStats.capacity * mib,
+                arenaStats.maxCapacity * mib);
+    ImGui::Text("  %u free ranges, %.0f%% fragmented", arenaStats.freeRanges, arenaStats.fragmentation * 100.0f);
+    ImGui::Text("  %d compactions, %d growths", arenaStats.compactions, arenaStats.growths);
+    if (ImGui::Button("Compact arena")) {
+        world->getVertexArena().compact();
+    }
+
+    int renderDistance = getOptionInt("render_distance", 7);
+    ImGui::Text("Render distance:");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(150);
+    if (ImGui::SliderInt("##RenderDistanceSlider", &renderDistance, 2, 32)) {
+        setOptionInt("render_distance", renderDistance);
+    }
+
     // Dropdown for block selection
     static std::vector<const char*> blockItems;
     static std::vector<uint8_t> blockIds;
@@ -36,14 +36,15 @@ void Renderer::init()
     std::string crosshairFragmentSource = loadShaderSource("shaders/crosshair_fragment.glsl");
     crosshairShaderProgram = createShaderProgram(crosshairVertexSource.c_str(), crosshairFragmentSource.c_str());
 
-    uModelLoc = glGetUniformLocation(shaderProgram, "model");
     uViewLoc = glGetUniformLocation(shaderProgram, "view");
     uProjLoc = glGetUniformLocation(shaderProgram, "projection");
     uAtlasLoc = glGetUniformLocation(shaderProgram, "atlas");
+    uSectionOriginsLoc = glGetUniformLocation(shaderProgram, "sectionOrigins");
     uAspectLoc = glGetUniformLocation(crosshairShaderProgram, "aspectRatio");
     uFogDensityLoc = glGetUniformLocation(shaderProgram, "fogDensity");
     uFogStartLoc = glGetUniformLocation(shaderProgram, "fogStartDistance");
     uFogColorLoc = glGetUniformLocation(shaderProgram, "fogColor");
+    uAlphaCutoffLoc = glGetUniformLocation(shaderProgram, "alphaCutoff");
 
     loadTextureAtlas("textures/atlas.png");
     initCrosshair();
@@ -81,6 +82,7 @@ void Renderer::initCrosshair() {
 void Renderer::renderWorld(const Camera& camera, float aspectRatio, float deltaTime) {
     int renderDist = getOptionInt("render_distance", 7) + 1; // +1 to account for invisible "mesh helper" chunk
     world.updateChunksAroundPlayer(camera.getPosition(), renderDist);
+    fogStartDistance = (renderDist * 16) - 29; // Render distance can change at runtime
 
     glUseProgram(shaderProgram);
 
@@ -115,6 +117,7 @@ void Renderer::renderWorld(const Camera& camera, float aspectRatio, float deltaT
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, textureAtlas);
     glUniform1i(uAtlasLoc, 0);
+    glUniform1i(uSectionOriginsLoc, VertexArena::ORIGIN_TEXTURE_UNIT);
 
     // Adjust fog density when zoomed in to avoid weird effect
     float adjustedFogDensity = fogDensity;
@@ -130,7 +133,19 @@ void Renderer::renderWorld(const Camera& camera, float aspectRatio, float deltaT
         glUniform1f(uFogDensityLoc, 0.0f); // Disable fog
     }
 
-    world.render(camera, uModelLoc);
+    // Cutout blocks (leaves) draw with the opaque ones, their see-through texels discarded
+    glUniform1f(uAlphaCutoffLoc, 0.5f);
+    world.render(camera, Chunk::RenderPass::Opaque);
+
+    // Transparent blocks blend over the finished opaque pass, depth tested but not written
+    // so they don't hide each other
+    glUniform1f(uAlphaCutoffLoc, 0.0f);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    world.render(camera, Chunk::RenderPass::Translucent);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
 
     glDisable(GL_DEPTH_TEST);
     renderCrosshair(aspectRatio);
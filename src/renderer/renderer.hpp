@@ -5,7 +5,7 @@
 
 class Renderer {
 public:
-    GLint uModelLoc, uViewLoc, uProjLoc, uAtlasLoc, uAspectLoc, uFogDensityLoc, uFogStartLoc, uFogColorLoc;
+    GLint uViewLoc, uProjLoc, uAtlasLoc, uSectionOriginsLoc, uAspectLoc, uFogDensityLoc, uFogStartLoc, uFogColorLoc, uAlphaCutoffLoc;
     Renderer();
     ~Renderer();
 
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <iostream>
+#include "vertexArena.hpp"
+#include "../world/chunkMesher.hpp"
+
+VertexArena::VertexArena(uint32_t initialCapacity) : capacity(initialCapacity) {
+    freeSpace.push_back({0, capacity});
+}
+
+VertexArena::~VertexArena() {
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    if (ebo != 0) glDeleteBuffers(1, &ebo);
+    if (originTexture != 0) glDeleteTextures(1, &originTexture);
+    if (originBuffer != 0) glDeleteBuffers(1, &originBuffer);
+}
+
+void VertexArena::createBuffers() {
+    // At least 65536 texels in GL 3.3, so at least 4M vertices
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    maxCapacity = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(std::max(maxTexels, 1)) * PAGE_SIZE,
+                                                           UINT32_MAX / PAGE_SIZE * PAGE_SIZE));
+    if (capacity > maxCapacity) {
+        capacity = maxCapacity;
+        freeSpace.assign(1, {0, capacity});
+    }
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity) * sizeof(PackedVertex), nullptr, GL_DYNAMIC_DRAW);
+
+    // Layout: one uvec2 per vertex (PackedVertex), unpacked by the vertex shader
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // Enough for most sections, grows if a mesh has more quads
+    ensureIndexedQuads(SectionMeshData::TYPICAL_VERTICES / 4);
+
+    glGenBuffers(1, &originBuffer);
+    glGenTextures(1, &originTexture);
+    pageOrigins.assign(capacity / PAGE_SIZE, glm::ivec4(0));
+    uploadPageOrigins();
+
+    glActiveTexture(GL_TEXTURE0 + ORIGIN_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, originTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32I, originBuffer);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VertexArena::uploadPageOrigins() {
+    glBindBuffer(GL_TEXTURE_BUFFER, originBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, pageOrigins.size() * sizeof(glm::ivec4), pageOrigins.data(), GL_DYNAMIC_DRAW);
+}
+
+void VertexArena::updatePageOrigins(const Range& range) {
+    uint32_t firstPage = range.offset / PAGE_SIZE;
+    uint32_t pageCount = range.size / PAGE_SIZE;
+    std::fill_n(pageOrigins.begin() + firstPage, pageCount, glm::ivec4(range.origin, 0));
+
+    glBindBuffer(GL_TEXTURE_BUFFER, originBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(firstPage) * sizeof(glm::ivec4),
+                    static_cast<GLsizeiptr>(pageCount) * sizeof(glm::ivec4), &pageOrigins[firstPage]);
+}
+
+void VertexArena::ensureIndexedQuads(uint32_t quadCount) {
+    if (quadCount <= indexedQuads) return;
+    indexedQuads = std::max(quadCount, indexedQuads * 2);
+
+    std::vector<unsigned int> indices(static_cast<size_t>(indexedQuads) * 6);
+    for (uint32_t quad = 0; quad < indexedQuads; ++quad) {
+        unsigned int first = quad * 4;
+        unsigned int* out = &indices[quad * 6];
+        out[0] = first;
+        out[1] = first + 1;
+        out[2] = first + 2;
+        out[3] = first + 2;
+        out[4] = first + 3;
+        out[5] = first;
+    }
+
+    // The element buffer binding is part of the VAO
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+bool VertexArena::takeSpace(uint32_t size, uint32_t& offset) {
+    // Best fit, keeps the big free ranges for big meshes
+    size_t best = freeSpace.size();
+    for (size_t i = 0; i < freeSpace.size(); ++i) {
+        if (freeSpace[i].size >= size && (best == freeSpace.size() || freeSpace[i].size < freeSpace[best].size)) {
+            best = i;
+            if (freeSpace[i].size == size) break;
+        }
+    }
+    if (best == freeSpace.size()) return false;
+
+    Space& space = freeSpace[best];
+    offset = space.offset;
+    space.offset += size;
+    space.size -= size;
+    if (space.size == 0) freeSpace.erase(freeSpace.begin() + best);
+    return true;
+}
+
+void VertexArena::releaseSpace(uint32_t offset, uint32_t size) {
+    auto next = std::lower_bound(freeSpace.begin(), freeSpace.end(), offset,
+        [](const Space& space, uint32_t value) { return space.offset < value; });
+    bool joinsPrevious = next != freeSpace.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+    bool joinsNext = next != freeSpace.end() && offset + size == next->offset;
+
+    if (joinsPrevious && joinsNext) {
+        std::prev(next)->size += size + next->size;
+        freeSpace.erase(next);
+    } else if (joinsPrevious) {
+        std::prev(next)->size += size;
+    } else if (joinsNext) {
+        next->offset = offset;
+        next->size += size;
+    } else {
+        freeSpace.insert(next, {offset, size});
+    }
+}
+
+uint32_t VertexArena::allocate(const PackedVertex* vertices, uint32_t count, const glm::ivec3& origin) {
+    if (count == 0) return INVALID_HANDLE;
+    if (vao == 0) createBuffers();
+    ensureIndexedQuads(count / 4);
+
+    uint32_t size = (count + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    uint32_t offset;
+    if (!takeSpace(size, offset)) {
+        // Compacting is enough if the arena stays at most 3/4 full, grow it otherwise
+        uint32_t needed = used + size;
+        if (needed <= capacity / 4 * 3 || capacity == maxCapacity) {
+            compact();
+        } else {
+            uint64_t newCapacity = static_cast<uint64_t>(capacity) * 2;
+            while (needed > newCapacity / 4 * 3) newCapacity *= 2;
+            relocate(static_cast<uint32_t>(std::min<uint64_t>(newCapacity, maxCapacity)));
+            growths++;
+        }
+        if (!takeSpace(size, offset)) {
+            // The section isn't drawn, its next upload tries again
+            if (!reportedFull) {
+                std::cerr << "Vertex arena full: " << maxCapacity << " vertices, the most GL_MAX_TEXTURE_BUFFER_SIZE allows"
+                          << " origin pages for. Some chunk meshes are not drawn, lower the render distance" << std::endl;
+                reportedFull = true;
+            }
+            return INVALID_HANDLE;
+        }
+    }
+
+    uint32_t handle;
+    if (freeHandles.empty()) {
+        handle = static_cast<uint32_t>(ranges.size());
+        ranges.emplace_back();
+    } else {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    ranges[handle] = {offset, size, count, origin};
+    used += size;
+
+    update(handle, vertices);
+    updatePageOrigins(ranges[handle]);
+    return handle;
+}
+
+void VertexArena::update(uint32_t handle, const PackedVertex* vertices) {
+    const Range& range = ranges[handle];
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(range.offset) * sizeof(PackedVertex),
+                    static_cast<GLsizeiptr>(range.count) * sizeof(PackedVertex), vertices);
+}
+
+void VertexArena::free(uint32_t handle) {
+    Range& range = ranges[handle];
+    releaseSpace(range.offset, range.size);
+    used -= range.size;
+    range = Range();
+    freeHandles.push_back(handle);
+}
+
+void VertexArena::compact() {
+    if (vao == 0 || freeSpace.size() <= 1) return;
+    relocate(capacity);
+    compactions++;
+}
+
+void VertexArena::relocate(uint32_t newCapacity) {
+    GLuint newVbo;
+    glGenBuffers(1, &newVbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newVbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(newCapacity) * sizeof(PackedVertex), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+
+    // Live ranges in buffer order, back to back
+    std::vector<Range*> live;
+    live.reserve(ranges.size() - freeHandles.size());
+    for (Range& range : ranges) {
+        if (range.size != 0) live.push_back(&range);
+    }
+    std::sort(live.begin(), live.end(), [](const Range* a, const Range* b) { return a->offset < b->offset; });
+
+    uint32_t offset = 0;
+    for (Range* range : live) {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            static_cast<GLintptr>(range->offset) * sizeof(PackedVertex),
+                            static_cast<GLintptr>(offset) * sizeof(PackedVertex),
+                            static_cast<GLsizeiptr>(range->count) * sizeof(PackedVertex));
+        range->offset = offset;
+        offset += range->size;
+    }
+
+    glDeleteBuffers(1, &vbo);
+    vbo = newVbo;
+    capacity = newCapacity;
+    freeSpace.clear();
+    if (offset < capacity) freeSpace.push_back({offset, capacity - offset});
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)0);
+    glBindVertexArray(0);
+
+    // Every page moved
+    pageOrigins.assign(capacity / PAGE_SIZE, glm::ivec4(0));
+    for (const Range* range : live) {
+        std::fill_n(pageOrigins.begin() + range->offset / PAGE_SIZE, range->size / PAGE_SIZE, glm::ivec4(range->origin, 0));
+    }
+    uploadPageOrigins();
+}
+
+void VertexArena::bind() const {
+    glBindVertexArray(vao);
+    glActiveTexture(GL_TEXTURE0 + ORIGIN_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, originTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VertexArena::queueDraw(uint32_t handle) {
+    const Range& range = ranges[handle];
+    drawCounts.push_back(static_cast<GLsizei>(range.count / 4 * 6));
+    drawIndices.push_back(nullptr); // Every range starts at the first quad of the index pattern
+    drawBaseVertices.push_back(static_cast<GLint>(range.offset));
+}
+
+int VertexArena::drawQueued() {
+    int drawCount = static_cast<int>(drawCounts.size());
+    if (drawCount != 0) {
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT, drawIndices.data(),
+                                      drawCount, drawBaseVertices.data());
+    }
+    drawCounts.clear();
+    drawIndices.clear();
+    drawBaseVertices.clear();
+    return drawCount;
+}
+
+VertexArena::Stats VertexArena::getStats() const {
+    Stats stats;
+    stats.capacity = capacity;
+    stats.maxCapacity = maxCapacity;
+    stats.used = used;
+    stats.freeRanges = static_cast<uint32_t>(freeSpace.size());
+    for (const Space& space : freeSpace) {
+        stats.largestFree = std::max(stats.largestFree, space.size);
+    }
+    uint32_t freeTotal = capacity - used;
+    stats.fragmentation = freeTotal ? 1.0f - static_cast<float>(stats.largestFree) / freeTotal : 0.0f;
+    stats.compactions = compactions;
+    stats.growths = growths;
+    return stats;
+}
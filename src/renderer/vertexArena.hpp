@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+struct PackedVertex;
+
+// One GL buffer holding the vertices of every chunk mesh, drawn through a single VAO.
+// Meshes get ranges of it from a best fit free list instead of buffers of their own, and
+// all quads are drawn with one shared index pattern (0 1 2 2 3 0, 4 more per quad) offset
+// by the range's first vertex. Ranges move when the arena grows or is compacted, so meshes
+// keep handles and look their range up when drawing.
+//
+// Each range has an origin (its section's position) the vertex shader adds to the vertex
+// positions. Ranges start on a PAGE_SIZE vertex boundary, so the shader finds the origin in
+// a texture buffer of one origin per page, at gl_VertexID / PAGE_SIZE. Any number of ranges
+// can then be drawn with a single glMultiDrawElementsBaseVertex, no per draw uniforms.
+// The page table can't outgrow GL_MAX_TEXTURE_BUFFER_SIZE texels, which caps the arena at
+// that many pages; once full, allocate fails until meshes are freed.
+class VertexArena {
+public:
+    static const uint32_t INVALID_HANDLE = UINT32_MAX;
+    // Ranges are reserved in multiples of this many vertices. Also keeps the page table small,
+    // and a rebuilt mesh that grew a little usually still fits the hole its previous version left.
+    static const uint32_t PAGE_SIZE = 64;
+    // Texture unit the page table is bound to by bind()
+    static const int ORIGIN_TEXTURE_UNIT = 1;
+
+    // Capacity in vertices, the GL objects are created by the first allocation
+    explicit VertexArena(uint32_t initialCapacity);
+    ~VertexArena();
+
+    VertexArena(const VertexArena&) = delete;
+    VertexArena& operator=(const VertexArena&) = delete;
+
+    // Copies count vertices (whole quads) into a new range, INVALID_HANDLE if count is 0 or
+    // the arena is at its largest and has no room left
+    uint32_t allocate(const PackedVertex* vertices, uint32_t count, const glm::ivec3& origin);
+    // Overwrites a range with as many vertices as it was allocated with
+    void update(uint32_t handle, const PackedVertex* vertices);
+    void free(uint32_t handle);
+
+    uint32_t getFirstVertex(uint32_t handle) const { return ranges[handle].offset; }
+    uint32_t getVertexCount(uint32_t handle) const { return ranges[handle].count; }
+
+    // Binds the VAO (vertex buffer and the shared index buffer) and the page table
+    void bind() const;
+    // Ranges are queued and drawn together by drawQueued, in queue order
+    void queueDraw(uint32_t handle);
+    // Returns the number of ranges drawn, the arena must be bound
+    int drawQueued();
+
+    // Moves every range to the front of the buffer, the free space becomes one range at the end
+    void compact();
+
+    struct Stats {
+        uint32_t capacity = 0;      // Vertices
+        uint32_t used = 0;          // Vertices reserved by live ranges
+        uint32_t freeRanges = 0;
+        uint32_t largestFree = 0;
+        float fragmentation = 0.0f; // 1 - largest free range / free space, 0 when it's all one range
+        uint32_t maxCapacity = 0;   // Vertices, set by GL_MAX_TEXTURE_BUFFER_SIZE
+        int compactions = 0;
+        int growths = 0;
+    };
+    Stats getStats() const;
+
+private:
+    struct Range {
+        uint32_t offset = 0;
+        uint32_t size = 0;  // Reserved vertices
+        uint32_t count = 0; // Vertices in use
+        glm::ivec3 origin = glm::ivec3(0);
+    };
+    std::vector<Range> ranges; // Indexed by handle
+    std::vector<uint32_t> freeHandles;
+    // Free ranges by offset, neighbours merged. A sorted vector rather than a map, so freeing
+    // and allocating don't allocate nodes.
+    struct Space {
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::vector<Space> freeSpace;
+
+    uint32_t capacity;
+    uint32_t maxCapacity = UINT32_MAX; // One vertex page per page table texel, queried by createBuffers
+    uint32_t used = 0;
+    int compactions = 0;
+    int growths = 0;
+    bool reportedFull = false;
+
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    uint32_t indexedQuads = 0; // Quads the shared index buffer covers
+
+    // Origin of every page (xyz, w unused), in originBuffer as an RGBA32I texture buffer
+    std::vector<glm::ivec4> pageOrigins;
+    GLuint originBuffer = 0, originTexture = 0;
+
+    // Draws queued for drawQueued
+    std::vector<GLsizei> drawCounts;
+    std::vector<const void*> drawIndices;
+    std::vector<GLint> drawBaseVertices;
+
+    void createBuffers();
+    bool takeSpace(uint32_t size, uint32_t& offset);
+    void releaseSpace(uint32_t offset, uint32_t size);
+    // Copies the live ranges back to back into a new buffer of newCapacity vertices
+    void relocate(uint32_t newCapacity);
+    void ensureIndexedQuads(uint32_t quadCount);
+    // Writes the range's origin into its pages
+    void updatePageOrigins(const Range& range);
+    // Uploads the whole page table, after the buffer was resized
+    void uploadPageOrigins();
+};
@@ -1,6 +1,7 @@
 #include "blockDB.hpp"
 
 std::unordered_map<uint8_t, BlockDB::BlockInfo> BlockDB::blockData;
+bool BlockDB::opaqueBlocks[256] = {};
 
 void BlockDB::initialize() {
     // Grass
@@ -144,7 +145,8 @@ void BlockDB::initialize() {
             glm::vec2(6.0f, 15.0f),
             glm::vec2(6.0f, 15.0f)
         },
-        true
+        true, // transparency
+        true  // cutout
     };
     
     //Cactus
@@ -159,6 +161,10 @@ void BlockDB::initialize() {
         },
         false
     };
+
+    for (const auto& entry : blockData) {
+        opaqueBlocks[entry.first] = !entry.second.transparent;
+    }
 }
 
 const BlockDB::BlockInfo* BlockDB::getBlockInfo(const uint8_t& blockName) {
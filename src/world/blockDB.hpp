@@ -8,11 +8,19 @@ public:
     struct BlockInfo {
         glm::vec2 textureCoords[6];
         bool transparent;
+        // Transparent texels are discarded instead of blended, so the block draws in the opaque pass
+        bool cutout = false;
+
+        // Drawn in the translucent pass
+        bool isBlended() const { return transparent && !cutout; }
     };
 
     static void initialize();
     static const BlockInfo* getBlockInfo(const uint8_t& blockName);
+    // Known and not transparent, air is not opaque
+    static bool isOpaque(uint8_t type) { return opaqueBlocks[type]; }
 
 private:
     static std::unordered_map<uint8_t, BlockInfo> blockData;
+    static bool opaqueBlocks[256];
 };
@@ -34,10 +34,26 @@ RaycastResult raycast(World* world, const glm::vec3& origin, const glm::vec3& di
     glm::ivec3 lastBlockPos = blockPos;
     Chunk* lastChunk = nullptr;
 
+    int cx = blockPos.x >> 4;
+    int cz = blockPos.z >> 4;
+    Chunk* chunk = world->getChunk(cx, cz);
+
     while (distanceTraveled < maxDistance) {
-        int cx = blockPos.x >> 4;
-        int cz = blockPos.z >> 4;
-        Chunk* chunk = world->getChunk(cx, cz);
+        int newCX = blockPos.x >> 4;
+        int newCZ = blockPos.z >> 4;
+        if (newCX != cx || newCZ != cz) {
+            // The ray only ever steps one block, so it crossed into a direct neighbour
+            if (chunk) {
+                if (newCX < cx) chunk = chunk->getNeighbor(2);
+                else if (newCX > cx) chunk = chunk->getNeighbor(3);
+                else if (newCZ < cz) chunk = chunk->getNeighbor(1);
+                else chunk = chunk->getNeighbor(0);
+            } else {
+                chunk = world->getChunk(newCX, newCZ);
+            }
+            cx = newCX;
+            cz = newCZ;
+        }
 
         if (chunk) {
             int lx = blockPos.x - cx * Chunk::WIDTH;
@@ -47,7 +63,8 @@ RaycastResult raycast(World* world, const glm::vec3& origin, const glm::vec3& di
             if (lx >= 0 && lx < Chunk::WIDTH &&
                 ly >= 0 && ly < Chunk::HEIGHT &&
                 lz >= 0 && lz < Chunk::DEPTH &&
-                chunk->blocks[lx][ly][lz].type != 0)
+                ly <= chunk->getHeight(lx, lz) &&
+                chunk->getBlock(lx, ly, lz) != 0)
             {
                 result.hit = true;
                 result.hitBlockPos = { lx, ly, lz };
@@ -83,6 +100,29 @@ RaycastResult raycast(World* world, const glm::vec3& origin, const glm::vec3& di
     return result;
 }
 
+// Remeshes the sections that can see the block at local position pos
+static void rebuildAroundBlock(Chunk* chunk, const glm::ivec3& pos)
+{
+    const int size = ChunkSection::SIZE;
+    int sectionY = pos.y / size;
+    chunk->buildSectionMesh(sectionY);
+
+    // Sections above/below share a face with blocks on the section boundary
+    if (pos.y % size == 0 && sectionY > 0) chunk->buildSectionMesh(sectionY - 1);
+    if (pos.y % size == size - 1 && sectionY < Chunk::SECTION_COUNT - 1) chunk->buildSectionMesh(sectionY + 1);
+
+    // Rebuild neighbor chunk section if at chunk edge
+    Chunk* neighbor = nullptr;
+    if (pos.x == 0) neighbor = chunk->getNeighbor(2);
+    else if (pos.x == Chunk::WIDTH - 1) neighbor = chunk->getNeighbor(3);
+    if (neighbor) neighbor->buildSectionMesh(sectionY);
+
+    neighbor = nullptr;
+    if (pos.z == 0) neighbor = chunk->getNeighbor(1);
+    else if (pos.z == Chunk::DEPTH - 1) neighbor = chunk->getNeighbor(0);
+    if (neighbor) neighbor->buildSectionMesh(sectionY);
+}
+
 void placeBreakBlockOnClick(World* world, const Camera& camera, char action, uint8_t blockType)
 {
     glm::vec3 origin = camera.getPosition();
@@ -90,53 +130,20 @@ void placeBreakBlockOnClick(World* world, const Camera& camera, char action, uin
 
     RaycastResult hit = raycast(world, origin, dir, 6.0f);
 
-    int cx = 0, cz = 0, x = 0, z = 0;
-
     // p = place, b = break
     if (action == 'b') {
         if (!hit.hit || !hit.hitChunk) return;
-        hit.hitChunk->blocks[hit.hitBlockPos.x][hit.hitBlockPos.y][hit.hitBlockPos.z].type = 0;
-        hit.hitChunk->buildMesh();
-
-        // Assign values for neighbor chunk checks
-        cx = hit.hitChunk->chunkX;
-        cz = hit.hitChunk->chunkZ;
-        x = hit.hitBlockPos.x;
-        z = hit.hitBlockPos.z;
+        hit.hitChunk->setBlock(hit.hitBlockPos.x, hit.hitBlockPos.y, hit.hitBlockPos.z, 0);
+        rebuildAroundBlock(hit.hitChunk, hit.hitBlockPos);
     }
     else if (action == 'p') {
         if (!hit.hasPlacePos || !hit.placeChunk) return;
         // Prevent placement below bedrock or above chunk height
         if (hit.placeBlockPos.y < 0 || hit.placeBlockPos.y >= Chunk::HEIGHT) return;
-        auto& block = hit.placeChunk->blocks[hit.placeBlockPos.x][hit.placeBlockPos.y][hit.placeBlockPos.z];
-        if (block.type != 0) return;
+        if (hit.placeChunk->getBlock(hit.placeBlockPos.x, hit.placeBlockPos.y, hit.placeBlockPos.z) != 0) return;
 
-        block.type = blockType;
-        hit.placeChunk->buildMesh();
-
-        // Assign values for neighbor chunk checks
-        cx = hit.placeChunk->chunkX;
-        cz = hit.placeChunk->chunkZ;
-        x = hit.placeBlockPos.x;
-        z = hit.placeBlockPos.z;
-    }
-
-    // Rebuild neighbor chunk mesh if at chunk edge
-    if (x == 0) {
-        Chunk* neighbor = world->getChunk(cx - 1, cz);
-        if (neighbor) neighbor->buildMesh();
-    }
-    if (x == Chunk::WIDTH - 1) {
-        Chunk* neighbor = world->getChunk(cx + 1, cz);
-        if (neighbor) neighbor->buildMesh();
-    }
-    if (z == 0) {
-        Chunk* neighbor = world->getChunk(cx, cz - 1);
-        if (neighbor) neighbor->buildMesh();
-    }
-    if (z == Chunk::DEPTH - 1) {
-        Chunk* neighbor = world->getChunk(cx, cz + 1);
-        if (neighbor) neighbor->buildMesh();
+        hit.placeChunk->setBlock(hit.placeBlockPos.x, hit.placeBlockPos.y, hit.placeBlockPos.z, blockType);
+        rebuildAroundBlock(hit.placeChunk, hit.placeBlockPos);
     }
 }
 
@@ -162,7 +169,7 @@ BlockInfo getLookedAtBlockInfo(World* world, const Camera& camera)
         hit.hitBlockPos.y,
         hit.hitChunk->chunkZ * Chunk::DEPTH + hit.hitBlockPos.z
     );
-    info.type = hit.hitChunk->blocks[hit.hitBlockPos.x][hit.hitBlockPos.y][hit.hitBlockPos.z].type;
+    info.type = hit.hitChunk->getBlock(hit.hitBlockPos.x, hit.hitBlockPos.y, hit.hitBlockPos.z);
 
     return info;
 }
\ No newline at end of file
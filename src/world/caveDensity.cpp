@@ -0,0 +1,141 @@
+#include <algorithm>
+#include "caveDensity.hpp"
+
+// Noise y is stretched so caves come out wider than they are high
+static const float VERTICAL_SCALE = 2.0f;
+
+static float bilerp(const float corners[2][2], float tx, float tz) {
+    float near = corners[0][0] + (corners[0][1] - corners[0][0]) * tx;
+    float far = corners[1][0] + (corners[1][1] - corners[1][0]) * tx;
+    return near + (far - near) * tz;
+}
+
+// Density inside a cell from its corners[y][z][x]. Carving and both isCarved go through the
+// same operations, so they always agree.
+static float trilerp(const float corners[2][2][2], float tx, float ty, float tz) {
+    float low = bilerp(corners[0], tx, tz);
+    float high = bilerp(corners[1], tx, tz);
+    return low + (high - low) * ty;
+}
+
+static float getFraction(int offset, int step) {
+    return offset * (1.0f / step);
+}
+
+void CaveDensity::sample(const ChunkNoises& noises, int chunkX, int chunkZ, int topY) {
+    layerCount = std::min(std::max(topY, 0) / STEP_Y + 2, POINTS_Y);
+
+    // The whole lattice in one batch
+    const int MAX_COUNT = POINTS_Y * POINTS_XZ * POINTS_XZ;
+    float xs[MAX_COUNT], ys[MAX_COUNT], zs[MAX_COUNT];
+    int count = 0;
+    for (int y = 0; y < layerCount; ++y) {
+        for (int z = 0; z < POINTS_XZ; ++z) {
+            for (int x = 0; x < POINTS_XZ; ++x) {
+                xs[count] = static_cast<float>(chunkX * Chunk::WIDTH + x * STEP_XZ);
+                ys[count] = static_cast<float>(y * STEP_Y) * VERTICAL_SCALE;
+                zs[count] = static_cast<float>(chunkZ * Chunk::DEPTH + z * STEP_XZ);
+                ++count;
+            }
+        }
+    }
+    noises.caveNoise.getNoise(xs, ys, zs, &samples[0][0][0], count);
+
+    // A section can only have caves if one of the lattice layers around it crosses THRESHOLD
+    for (int sectionY = 0; sectionY < Chunk::SECTION_COUNT; ++sectionY) {
+        int firstLayer = sectionY * ChunkSection::SIZE / STEP_Y;
+        int lastLayer = std::min((sectionY + 1) * ChunkSection::SIZE / STEP_Y, layerCount - 1);
+
+        bool crossing = false;
+        for (int y = firstLayer; y <= lastLayer && !crossing; ++y) {
+            const float* layer = &samples[y][0][0];
+            for (int i = 0; i < POINTS_XZ * POINTS_XZ; ++i) {
+                if (layer[i] > THRESHOLD) {
+                    crossing = true;
+                    break;
+                }
+            }
+        }
+        sectionHasCaves[sectionY] = crossing;
+    }
+}
+
+void CaveDensity::carveSection(int sectionY, const int* ceilings, uint8_t* blocks) const {
+    const int SIZE = ChunkSection::SIZE;
+    const int bottom = sectionY * SIZE;
+
+    for (int cellY = bottom / STEP_Y; cellY < (bottom + SIZE) / STEP_Y && cellY + 1 < layerCount; ++cellY) {
+        for (int cellZ = 0; cellZ < POINTS_XZ - 1; ++cellZ) {
+            for (int cellX = 0; cellX < POINTS_XZ - 1; ++cellX) {
+                float corners[2][2][2];
+                float maxCorner = -1.0f;
+                for (int i = 0; i < 8; ++i) {
+                    int dy = i >> 2, dz = (i >> 1) & 1, dx = i & 1;
+                    corners[dy][dz][dx] = samples[cellY + dy][cellZ + dz][cellX + dx];
+                    maxCorner = std::max(maxCorner, corners[dy][dz][dx]);
+                }
+                // Interpolation stays between the corners, no crossing in this cell
+                if (maxCorner <= THRESHOLD) continue;
+
+                for (int dz = 0; dz < STEP_XZ; ++dz) {
+                    for (int dx = 0; dx < STEP_XZ; ++dx) {
+                        int x = cellX * STEP_XZ + dx;
+                        int z = cellZ * STEP_XZ + dz;
+                        int ceiling = ceilings[x * Chunk::DEPTH + z];
+
+                        float tx = getFraction(dx, STEP_XZ);
+                        float tz = getFraction(dz, STEP_XZ);
+                        float low = bilerp(corners[0], tx, tz);
+                        float high = bilerp(corners[1], tx, tz);
+                        if (low <= THRESHOLD && high <= THRESHOLD) continue; // Linear in y, can't cross
+
+                        for (int dy = 0; dy < STEP_Y; ++dy) {
+                            int y = cellY * STEP_Y + dy;
+                            if (y > ceiling) break;
+                            if (y < 1) continue; // Bedrock
+
+                            float density = low + (high - low) * getFraction(dy, STEP_Y);
+                            if (density > THRESHOLD) {
+                                blocks[((y - bottom) * SIZE + z) * SIZE + x] = 0;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool CaveDensity::isCarved(int x, int y, int z) const {
+    int cellX = x / STEP_XZ, cellY = y / STEP_Y, cellZ = z / STEP_XZ;
+    if (y < 1 || cellY + 1 >= layerCount) return false;
+
+    float corners[2][2][2];
+    for (int i = 0; i < 8; ++i) {
+        int dy = i >> 2, dz = (i >> 1) & 1, dx = i & 1;
+        corners[dy][dz][dx] = samples[cellY + dy][cellZ + dz][cellX + dx];
+    }
+    return trilerp(corners, getFraction(x - cellX * STEP_XZ, STEP_XZ), getFraction(y - cellY * STEP_Y, STEP_Y),
+                   getFraction(z - cellZ * STEP_XZ, STEP_XZ)) > THRESHOLD;
+}
+
+bool CaveDensity::isCarved(const ChunkNoises& noises, int worldX, int y, int worldZ) {
+    int cellY = y / STEP_Y;
+    if (y < 1 || cellY + 1 >= POINTS_Y) return false;
+
+    // Floor division, the lattice continues through negative coordinates
+    int cellX = (worldX >= 0) ? worldX / STEP_XZ : -((-worldX + STEP_XZ - 1) / STEP_XZ);
+    int cellZ = (worldZ >= 0) ? worldZ / STEP_XZ : -((-worldZ + STEP_XZ - 1) / STEP_XZ);
+
+    float xs[8], ys[8], zs[8], corners[2][2][2];
+    for (int i = 0; i < 8; ++i) {
+        int dy = i >> 2, dz = (i >> 1) & 1, dx = i & 1;
+        xs[i] = static_cast<float>((cellX + dx) * STEP_XZ);
+        ys[i] = static_cast<float>((cellY + dy) * STEP_Y) * VERTICAL_SCALE;
+        zs[i] = static_cast<float>((cellZ + dz) * STEP_XZ);
+    }
+    noises.caveNoise.getNoise(xs, ys, zs, &corners[0][0][0], 8);
+
+    return trilerp(corners, getFraction(worldX - cellX * STEP_XZ, STEP_XZ), getFraction(y - cellY * STEP_Y, STEP_Y),
+                   getFraction(worldZ - cellZ * STEP_XZ, STEP_XZ)) > THRESHOLD;
+}
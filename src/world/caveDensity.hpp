@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include "chunk.hpp"
+#include "noise.hpp"
+
+// 3D cave density of a chunk: caveNoise sampled every STEP_XZ x STEP_Y x STEP_XZ blocks and
+// trilinearly interpolated in between, blocks where it's above THRESHOLD are carved out.
+// That's 825 noise samples for a whole chunk instead of 65536. The lattice is aligned to
+// world coordinates, so any block's density can also be computed without the chunk.
+class CaveDensity {
+public:
+    static const int STEP_XZ = 4;
+    static const int STEP_Y = 8;
+    static const int POINTS_XZ = Chunk::WIDTH / STEP_XZ + 1;
+    static const int POINTS_Y = Chunk::HEIGHT / STEP_Y + 1;
+    static constexpr float THRESHOLD = 0.45f;
+
+    // Samples the lattice layers covering y 0 to topY, nothing above topY is ever carved
+    void sample(const ChunkNoises& noises, int chunkX, int chunkZ, int topY);
+
+    // False when every lattice corner around the section is below THRESHOLD, nothing to carve then
+    bool hasCaves(int sectionY) const { return sectionHasCaves[sectionY]; }
+
+    // Sets the carved blocks of a section to air, blocks in (y * SIZE + z) * SIZE + x order.
+    // Only carves from y 1 (above bedrock) up to ceilings[x * DEPTH + z].
+    void carveSection(int sectionY, const int* ceilings, uint8_t* blocks) const;
+
+    // Whether the block at chunk coordinates (x, y, z) is carved (ignoring ceilings), same
+    // result as carveSection
+    bool isCarved(int x, int y, int z) const;
+    // Same for a block of any chunk, samples the 8 corners of its cell
+    static bool isCarved(const ChunkNoises& noises, int worldX, int y, int worldZ);
+
+private:
+    float samples[POINTS_Y][POINTS_XZ][POINTS_XZ]; // [y][z][x]
+    int layerCount = 0;
+    bool sectionHasCaves[Chunk::SECTION_COUNT] = {};
+};
@@ -1,275 +1,235 @@
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
-#include <set>
+#include <cstring>
 #include "chunk.hpp"
+#include "world.hpp"
 #include "../core/options.hpp"
-#include "noise.hpp"
 #include "chunkTerrain.hpp"
+#include "chunkMesher.hpp"
 
-struct pendingBlock {
-    int x, y, z;
-    uint8_t type;
-};
-static std::map<std::pair<int, int>, std::vector<pendingBlock >> pendingBlockPlacements;
+Chunk::MeshingMode Chunk::meshingMode = Chunk::MeshingMode::Greedy;
 
 Chunk::Chunk(int x, int z, World* worldPtr)
-    : chunkX(x), chunkZ(z), world(worldPtr), VAO(0), VBO(0), EBO(0), indexCount(0)
+    : chunkX(x), chunkZ(z), world(worldPtr)
 {
-    noises = noiseInit();
-    generateChunkTerrain(*this);
-
-    // Apply any pending block placements for this chunk
-    auto key = std::make_pair(chunkX, chunkZ);
-    auto it = pendingBlockPlacements.find(key);
-    if (it != pendingBlockPlacements.end()) {
-        for (const auto& pb : it->second) {
-            if (pb.x >= 0 && pb.x < WIDTH && pb.y >= 0 && pb.y < HEIGHT && pb.z >= 0 && pb.z < DEPTH) {
-                blocks[pb.x][pb.y][pb.z].type = pb.type;
-            }
-        }
-        pendingBlockPlacements.erase(it);
-        buildMesh();
-    }
+    std::fill(std::begin(heightmap), std::end(heightmap), -1);
+    std::fill(std::begin(opaqueHeightmap), std::end(opaqueHeightmap), -1);
+    generateChunkTerrain(*this, world->getGenerator(), world->getColumnCache());
 }
 
 Chunk::~Chunk() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-}
+    for (int sectionY = 0; sectionY < SECTION_COUNT; ++sectionY) {
+        clearMesh(sectionY);
+    }
 
-void Chunk::placeStructure(const Structure& structure, int baseX, int baseY, int baseZ) {
-    int structHeight = (int)structure.layers.size();
-    int structDepth = (int)structure.layers[0].size();
-    int structWidth = (int)structure.layers[0][0].size();
-    std::set<Chunk*> affectedChunks; // Track which chunks are affected
-
-    for (int y = 0; y < structHeight; ++y) {
-        for (int z = 0; z < structDepth; ++z) {
-            for (int x = 0; x < structWidth; ++x) {
-                uint8_t blockType = structure.layers[y][z][x];
-                if (blockType == 0) continue;
-                int wx = baseX + x;
-                int wy = baseY + y;
-                int wz = baseZ + z;
-
-                // Compute which chunk this block belongs to
-                int chunkOffsetX = 0, chunkOffsetZ = 0;
-                int localX = wx, localZ = wz;
-                if (wx < 0) {
-                    chunkOffsetX = (wx / WIDTH) - (wx % WIDTH != 0 ? 1 : 0);
-                    localX = wx - chunkOffsetX * WIDTH;
-                } else if (wx >= WIDTH) {
-                    chunkOffsetX = wx / WIDTH;
-                    localX = wx - chunkOffsetX * WIDTH;
-                }
-                if (wz < 0) {
-                    chunkOffsetZ = (wz / DEPTH) - (wz % DEPTH != 0 ? 1 : 0);
-                    localZ = wz - chunkOffsetZ * DEPTH;
-                } else if (wz >= DEPTH) {
-                    chunkOffsetZ = wz / DEPTH;
-                    localZ = wz - chunkOffsetZ * DEPTH;
-                }
-
-                int targetChunkX = chunkX + chunkOffsetX;
-                int targetChunkZ = chunkZ + chunkOffsetZ;
-
-                if (wy >= 0 && wy < HEIGHT) {
-                    Chunk* targetChunk = nullptr;
-                    if (chunkOffsetX == 0 && chunkOffsetZ == 0) {
-                        targetChunk = this;
-                    } else if (world) {
-                        targetChunk = world->getChunk(targetChunkX, targetChunkZ);
-                    }
-                    if (targetChunk &&
-                        localX >= 0 && localX < WIDTH &&
-                        localZ >= 0 && localZ < DEPTH) {
-                        targetChunk->blocks[localX][wy][localZ].type = blockType;
-                        affectedChunks.insert(targetChunk);
-                    } else {
-                        // Chunk not loaded, defer placement
-                        auto key = std::make_pair(targetChunkX, targetChunkZ);
-                        pendingBlockPlacements[key].push_back({localX, wy, localZ, blockType});
-                    }
-                }
-            }
-        }
+    // Don't leave the neighbours pointing at freed memory
+    for (int face = 0; face < 4; ++face) {
+        if (neighbors[face]) neighbors[face]->neighbors[oppositeFace(face)] = nullptr;
     }
-    // Rebuild mesh for all affected chunks
-    for (Chunk* chunk : affectedChunks) {
-        chunk->buildMesh();
+}
+
+void Chunk::linkNeighbor(int face, Chunk* neighbor) {
+    neighbors[face] = neighbor;
+    if (neighbor) neighbor->neighbors[oppositeFace(face)] = this;
+}
+
+size_t Chunk::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (const ChunkSection& section : sections) {
+        bytes += section.getMemoryUsage();
     }
+    return bytes;
 }
 
-void Chunk::buildMesh() {
-    // Defer mesh generation if any neighbor chunk is missing
-    for (int face = 0; face < 6; ++face) {
-        int nx = 0, ny = 0, nz = 0;
-        switch (face) {
-            case 0: nx = chunkX;     ny = 0; nz = chunkZ + 1; break; // front
-            case 1: nx = chunkX;     ny = 0; nz = chunkZ - 1; break; // back
-            case 2: nx = chunkX - 1; ny = 0; nz = chunkZ;     break; // left
-            case 3: nx = chunkX + 1; ny = 0; nz = chunkZ;     break; // right
-            case 4: continue; // top face (no neighbor needed)
-            case 5: continue; // bottom face (no neighbor needed)
-        }
-        if (world->getChunk(nx, nz) == nullptr) { // Neighbor chunk missing = skip mesh generation for now
-            return;
+void Chunk::placeStructure(const Structure& structure, int baseX, int baseY, int baseZ) {
+    // Clip the bounding box to the chunk once, the neighbours stamp the rest of the structure
+    int x0 = std::max(baseX + structure.minX, 0);
+    int x1 = std::min(baseX + structure.maxX, WIDTH - 1);
+    int y0 = std::max(baseY + structure.minY, 0);
+    int y1 = std::min(baseY + structure.maxY, HEIGHT - 1);
+    int z0 = std::max(baseZ + structure.minZ, 0);
+    int z1 = std::min(baseZ + structure.maxZ, DEPTH - 1);
+    if (x0 > x1 || y0 > y1 || z0 > z1) return;
+
+    for (const Structure::Run& run : structure.runs) {
+        int y = baseY + run.y;
+        int z = baseZ + run.z;
+        if (y < y0 || y > y1 || z < z0 || z > z1) continue;
+
+        int from = std::max(baseX + run.x, x0);
+        int to = std::min(baseX + run.x + run.length - 1, x1);
+        if (from > to) continue;
+        sections[y / ChunkSection::SIZE].setRun(from, y % ChunkSection::SIZE, z, to - from + 1, run.type);
+        for (int x = from; x <= to; ++x) {
+            updateHeightmaps(x, y, z, run.type);
         }
     }
+}
 
-    if (VAO != 0) {
-        glDeleteVertexArrays(1, &VAO);
-        VAO = 0;
+void Chunk::initHeightmaps(const int* heights, const int* opaqueHeights) {
+    maxHeight = -1;
+    for (int i = 0; i < WIDTH * DEPTH; ++i) {
+        heightmap[i] = static_cast<int16_t>(heights[i]);
+        opaqueHeightmap[i] = static_cast<int16_t>(opaqueHeights[i]);
+        maxHeight = std::max(maxHeight, heights[i]);
     }
-    if (VBO != 0) {
-        glDeleteBuffers(1, &VBO);
-        VBO = 0;
+}
+
+void Chunk::updateHeightmaps(int x, int y, int z, uint8_t type) {
+    int16_t& height = heightmap[x * DEPTH + z];
+    int16_t& opaqueHeight = opaqueHeightmap[x * DEPTH + z];
+
+    // Only removing the top block needs a scan down the column
+    if (type != 0) {
+        if (y > height) height = static_cast<int16_t>(y);
+    } else if (y == height) {
+        while (height >= 0 && getBlock(x, height, z) == 0) --height;
     }
-    if (EBO != 0) {
-        glDeleteBuffers(1, &EBO);
-        EBO = 0;
+
+    if (BlockDB::isOpaque(type)) {
+        if (y > opaqueHeight) opaqueHeight = static_cast<int16_t>(y);
+    } else if (y == opaqueHeight) {
+        while (opaqueHeight >= 0 && !BlockDB::isOpaque(getBlock(x, opaqueHeight, z))) --opaqueHeight;
     }
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    unsigned int indexOffset = 0;
-
-    for (int x = 0; x < WIDTH; ++x) {
-        for (int y = 0; y < HEIGHT; ++y) {
-            for (int z = 0; z < DEPTH; ++z) {
-                const uint8_t& type = blocks[x][y][z].type;
-                if (type == 0) continue;
-
-                const BlockDB::BlockInfo* info = BlockDB::getBlockInfo(type);
-                if (!info) continue;
-
-                for (int face = 0; face < 6; ++face) {
-                    if (isBlockVisible(x, y, z, face)) {
-                        addFace(vertices, indices, x, y, z, face, info, indexOffset);
-                    }
-                }
-            }
-        }
+
+    if (height > maxHeight) {
+        maxHeight = height;
+    } else if (y == maxHeight && height < y) {
+        // The highest column got lower
+        maxHeight = *std::max_element(heightmap, heightmap + WIDTH * DEPTH);
     }
+}
 
-    indexCount = static_cast<GLsizei>(indices.size());
+bool Chunk::takeSnapshot(int sectionY, SectionSnapshot& snapshot) const {
+    // Defer mesh generation if any neighbor chunk is missing
+    const Chunk* front = neighbors[0];
+    const Chunk* back = neighbors[1];
+    const Chunk* left = neighbors[2];
+    const Chunk* right = neighbors[3];
+    if (!front || !back || !left || !right) {
+        return false;
+    }
 
-    // Create mesh
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    const int size = SectionSnapshot::SIZE;
+    const int baseY = sectionY * size;
 
-    glBindVertexArray(VAO);
+    snapshot.chunkX = chunkX;
+    snapshot.chunkZ = chunkZ;
+    snapshot.sectionY = sectionY;
+    snapshot.topY = std::min(maxHeight - baseY, size - 1);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    // Air outside the world and in the corners, which are never read
+    std::memset(snapshot.blocks, 0, sizeof(snapshot.blocks));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    // Nothing but air above the chunk's highest block
+    int lastY = std::min(maxHeight - baseY, size);
+    for (int y = -1; y <= lastY; ++y) {
+        int wy = baseY + y;
+        if (wy < 0 || wy >= HEIGHT) continue;
 
-    // Layout: position (3), uv (2), faceID (1)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(5 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+        for (int z = 0; z < size; ++z) {
+            for (int x = 0; x < size; ++x) {
+                snapshot.set(x, y, z, getBlock(x, wy, z));
+            }
+        }
 
-    glBindVertexArray(0);
+        // Neighbour border slices, only the section's own layers are read sideways
+        if (y < 0 || y == size) continue;
+        for (int i = 0; i < size; ++i) {
+            snapshot.set(i, y, size, front->getBlock(i, wy, 0));
+            snapshot.set(i, y, -1, back->getBlock(i, wy, DEPTH - 1));
+            snapshot.set(-1, y, i, left->getBlock(WIDTH - 1, wy, i));
+            snapshot.set(size, y, i, right->getBlock(0, wy, i));
+        }
+    }
+    return true;
 }
 
-bool Chunk::isBlockVisible(int x, int y, int z, int face) const {
-    static const int offsets[6][3] = {
-        { 0,  0,  1},  // front
-        { 0,  0, -1},  // back
-        {-1,  0,  0},  // left
-        { 1,  0,  0},  // right
-        { 0,  1,  0},  // top
-        { 0, -1,  0}   // bottom
-    };
-
-    int nx = x + offsets[face][0];
-    int ny = y + offsets[face][1];
-    int nz = z + offsets[face][2];
-
-    // Check height bounds
-    if (ny < 0 || ny >= HEIGHT)
-        return true;
-
-    // If neighbor is within current chunk
-    if (nx >= 0 && nx < WIDTH && nz >= 0 && nz < DEPTH) {
-        return blocks[nx][ny][nz].type == 0;
+void Chunk::buildMesh() {
+    for (int sectionY = 0; sectionY < SECTION_COUNT; ++sectionY) {
+        buildSectionMesh(sectionY);
     }
+}
 
-    // Neighbor is in another chunk
-    int neighborChunkX = chunkX;
-    int neighborChunkZ = chunkZ;
-    int lx = nx;
-    int lz = nz;
-
-    if (lx < 0) {
-        neighborChunkX -= 1;
-        lx += WIDTH;
-    } else if (lx >= WIDTH) {
-        neighborChunkX += 1;
-        lx -= WIDTH;
-    }
+void Chunk::buildSectionMesh(int sectionY) {
+    // Any mesh still being built on a worker is now out of date
+    meshes[sectionY].revision = world->nextMeshRevision();
 
-    if (lz < 0) {
-        neighborChunkZ -= 1;
-        lz += DEPTH;
-    } else if (lz >= DEPTH) {
-        neighborChunkZ += 1;
-        lz -= DEPTH;
+    if (isSectionEmpty(sectionY)) {
+        clearMesh(sectionY);
+        return;
     }
 
-    Chunk* neighbor = world->getChunk(neighborChunkX, neighborChunkZ);
-    if (!neighbor)
-        return true;  // If no neighbor, assume empty
+    // Per thread scratch, reused by every synchronous rebuild
+    static thread_local SectionSnapshot snapshot;
+    static thread_local SectionMeshData mesh;
+    if (mesh.opaque.capacity() == 0) mesh.reserveTypical();
 
-    return neighbor->blocks[lx][ny][lz].type == 0;
+    if (!takeSnapshot(sectionY, snapshot)) return;
+    ::buildSectionMesh(snapshot, meshingMode, mesh);
+    uploadMesh(sectionY, mesh);
 }
 
-void Chunk::addFace(std::vector<float>& vertices, std::vector<unsigned int>& indices,
-                    int x, int y, int z, int face, const BlockDB::BlockInfo* blockInfo, unsigned int& indexOffset) {
-    static const glm::vec3 faceVertices[6][4] = {
-        {{0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}}, // Front
-        {{1,0,0}, {0,0,0}, {0,1,0}, {1,1,0}}, // Back
-        {{0,0,0}, {0,0,1}, {0,1,1}, {0,1,0}}, // Left
-        {{1,0,1}, {1,0,0}, {1,1,0}, {1,1,1}}, // Right
-        {{0,1,1}, {1,1,1}, {1,1,0}, {0,1,0}}, // Top
-        {{0,0,0}, {1,0,0}, {1,0,1}, {0,0,1}}  // Bottom
-    };
-
-    static const glm::vec2 uvs[4] = {
-        {0.0f, 0.0f},
-        {1.0f, 0.0f},
-        {1.0f, 1.0f},
-        {0.0f, 1.0f}
-    };
-
-    glm::vec2 texOffset = blockInfo->textureCoords[face] / 16.0f;
-
-    for (int i = 0; i < 4; ++i) {
-        glm::vec3 pos = faceVertices[face][i] + glm::vec3(x, y, z);
-        glm::vec2 uv = (blockInfo->textureCoords[face] + uvs[i]) / 16.0f;
-        vertices.insert(vertices.end(), {pos.x, pos.y, pos.z, uv.x, uv.y, static_cast<float>(face)});
+void Chunk::uploadRange(uint32_t& range, const std::vector<PackedVertex>& vertices, int sectionY) {
+    VertexArena& arena = world->getVertexArena();
+    uint32_t count = static_cast<uint32_t>(vertices.size());
+
+    // Same size as before (a block was swapped for another) is rewritten in place
+    if (range != VertexArena::INVALID_HANDLE && arena.getVertexCount(range) == count) {
+        arena.update(range, vertices.data());
+        return;
     }
+    if (range != VertexArena::INVALID_HANDLE) arena.free(range);
+    range = arena.allocate(vertices.data(), count, glm::ivec3(chunkX * WIDTH, sectionY * ChunkSection::SIZE, chunkZ * DEPTH));
+}
+
+void Chunk::uploadMesh(int sectionY, const SectionMeshData& data) {
+    SectionMesh& mesh = meshes[sectionY];
+    mesh.vertexCount = data.vertexCount;
+    mesh.meshTimeMs = data.meshTimeMs;
+    mesh.uploadedRevision = mesh.revision;
 
-    indices.insert(indices.end(), {
-        indexOffset, indexOffset + 1, indexOffset + 2,
-        indexOffset + 2, indexOffset + 3, indexOffset
-    });
+    uploadRange(mesh.ranges[static_cast<int>(RenderPass::Opaque)], data.opaque, sectionY);
+    uploadRange(mesh.ranges[static_cast<int>(RenderPass::Translucent)], data.translucent, sectionY);
 
-    indexOffset += 4;
+    // Mesher order until World sorts it. A sort still running is for the old mesh, World drops
+    // it and sorts this one once it's back.
+    mesh.translucentVertices.assign(data.translucent.begin(), data.translucent.end());
+    mesh.sorted = false;
+}
+
+void Chunk::updateTranslucentVertices(int sectionY, const std::vector<PackedVertex>& vertices) {
+    uint32_t range = meshes[sectionY].ranges[static_cast<int>(RenderPass::Translucent)];
+    VertexArena& arena = world->getVertexArena();
+    if (range == VertexArena::INVALID_HANDLE || arena.getVertexCount(range) != vertices.size()) return;
+    arena.update(range, vertices.data());
+}
+
+void Chunk::clearMesh(int sectionY) {
+    SectionMesh& mesh = meshes[sectionY];
+    for (uint32_t& range : mesh.ranges) {
+        if (range != VertexArena::INVALID_HANDLE) world->getVertexArena().free(range);
+        range = VertexArena::INVALID_HANDLE;
+    }
+    mesh.vertexCount = 0;
+    mesh.meshTimeMs = 0.0f;
+    mesh.uploadedRevision = 0;
+    mesh.translucentVertices.clear();
+    mesh.sorted = false;
+}
+
+void Chunk::queueDraws(RenderPass pass) const {
+    for (int sectionY = 0; sectionY < SECTION_COUNT; ++sectionY) {
+        queueSectionDraw(sectionY, pass);
+    }
 }
 
-void Chunk::render(const Camera& camera, GLint uModelLoc) {
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(chunkX * WIDTH, 0, chunkZ * DEPTH));
-    glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, &model[0][0]);
+void Chunk::queueSectionDraw(int sectionY, RenderPass pass) const {
+    uint32_t range = meshes[sectionY].ranges[static_cast<int>(pass)];
+    if (range == VertexArena::INVALID_HANDLE) return; // Empty, fully hidden or nothing in this pass
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    // The section's position comes from the range's origin, no model matrix
+    world->getVertexArena().queueDraw(range);
 }
\ No newline at end of file
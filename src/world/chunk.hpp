@@ -4,19 +4,20 @@
 #include <glad/glad.h>
 #include "blockDB.hpp"
 #include "../core/camera.hpp"
-#include "world.hpp"
 #include "structureDB.hpp"
-#include "noise.hpp"
+#include "chunkSection.hpp"
+#include "../renderer/vertexArena.hpp"
 
 class World;
+struct SectionSnapshot;
+struct SectionMeshData;
 
 class Chunk {
 public:
     static const int WIDTH = 16;
     static const int HEIGHT = 256;
     static const int DEPTH = 16;
-
-    ChunkNoises noises;
+    static const int SECTION_COUNT = HEIGHT / ChunkSection::SIZE;
 
     enum class Biome {
         Plains,
@@ -24,31 +25,116 @@ public:
         Forest
     };
 
-    struct Block {
-        uint8_t type;
+    enum class MeshingMode {
+        PerFace, // One quad per visible block face
+        Greedy   // Coplanar faces with the same texture merged into rectangles
+    };
+    static MeshingMode meshingMode;
+
+    enum class RenderPass {
+        Opaque,     // Depth written, drawn first
+        Translucent // Transparent blocks, blended over the opaque pass
     };
 
+    // Generates terrain and features, touches nothing outside the chunk so it can run on a worker thread
     Chunk(int x, int z, World* worldRef);
     ~Chunk();
 
+    // Mesh and upload right away, World::requestMesh does the meshing on a worker instead
     void buildMesh();
-    void render(const Camera& camera, GLint uModelLoc);
+    void buildSectionMesh(int sectionY);
+    // Copies the blocks the mesher needs, false if a neighbour isn't loaded yet
+    bool takeSnapshot(int sectionY, SectionSnapshot& snapshot) const;
+    // GL thread only, the previous mesh is kept until the new one is uploaded
+    void uploadMesh(int sectionY, const SectionMeshData& mesh);
+    // Drops the mesh of a section that became empty
+    void clearMesh(int sectionY);
+    // Queue the pass's ranges in the world's VertexArena, World::render draws them all at once
+    void queueDraws(RenderPass pass) const;
+    void queueSectionDraw(int sectionY, RenderPass pass) const;
+    // Base is in chunk coordinates and may lie outside it, only the blocks inside the chunk are written
     void placeStructure(const Structure& structure, int baseX, int baseY, int baseZ);
 
-    Block blocks[WIDTH][HEIGHT][DEPTH];
+    // Block access, y goes through the 16 high palette sections
+    uint8_t getBlock(int x, int y, int z) const {
+        return sections[y / ChunkSection::SIZE].get(x, y % ChunkSection::SIZE, z);
+    }
+    void setBlock(int x, int y, int z, uint8_t type) {
+        sections[y / ChunkSection::SIZE].set(x, y % ChunkSection::SIZE, z, type);
+        updateHeightmaps(x, y, z, type);
+    }
+
+    // Highest non-air and highest opaque block of a column, -1 if there is none
+    int getHeight(int x, int z) const { return heightmap[x * DEPTH + z]; }
+    int getOpaqueHeight(int x, int z) const { return opaqueHeightmap[x * DEPTH + z]; }
+    // Highest non-air block of the whole chunk, -1 if it's empty
+    int getMaxHeight() const { return maxHeight; }
+    // For generation, which writes whole sections: both heightmaps indexed [x * DEPTH + z]
+    void initHeightmaps(const int* heights, const int* opaqueHeights);
+
+    bool isSectionEmpty(int sectionY) const { return sections[sectionY].isEmpty(); }
+    // Whole sections for bulk writes, skips the per-block palette lookups
+    ChunkSection& getSection(int sectionY) { return sections[sectionY]; }
+
+    // Horizontal neighbours, indexed like the block faces: 0 front (+z), 1 back (-z), 2 left (-x), 3 right (+x).
+    // Kept up to date by World, nullptr while the neighbour isn't loaded.
+    Chunk* getNeighbor(int face) const { return neighbors[face]; }
+    static int oppositeFace(int face) { return face ^ 1; }
+
+    // Bytes used by block storage
+    size_t getMemoryUsage() const;
+
     int chunkX, chunkZ;
     Biome biome;
 
+    // Time spent in each generation stage (for ImGui)
+    struct GenerationTimes {
+        float terrainMs = 0.0f; // Columns, blending and block layers
+        float cavesMs = 0.0f;   // Density sampling and carving
+        float featuresMs = 0.0f;
+    };
+    GenerationTimes generationTimes;
+
 private:
     World* world;
 
-    GLuint VAO, VBO, EBO;
-    GLsizei indexCount;
+    ChunkSection sections[SECTION_COUNT];
+    Chunk* neighbors[4] = {nullptr, nullptr, nullptr, nullptr};
+
+    // Kept up to date by setBlock and placeStructure
+    int16_t heightmap[WIDTH * DEPTH];
+    int16_t opaqueHeightmap[WIDTH * DEPTH];
+    int maxHeight = -1;
+
+    void updateHeightmaps(int x, int y, int z, uint8_t type);
 
-    void addFace(std::vector<float>& vertices, std::vector<unsigned int>& indices,
-                 int x, int y, int z, int face, const BlockDB::BlockInfo* blockInfo, unsigned int& indexOffset);
+    void linkNeighbor(int face, Chunk* neighbor);
 
-    bool isBlockVisible(int x, int y, int z, int face) const;
+    struct SectionMesh {
+        // Vertex ranges in the world's VertexArena, indexed by RenderPass
+        uint32_t ranges[2] = {VertexArena::INVALID_HANDLE, VertexArena::INVALID_HANDLE};
+
+        // Stats of the last mesh build (for ImGui)
+        size_t vertexCount = 0;
+        float meshTimeMs = 0.0f;
+
+        // Revision of the newest mesh request, older meshes coming back from workers are dropped
+        uint64_t revision = 0;
+        // Revision of the mesh on the GPU
+        uint64_t uploadedRevision = 0;
+
+        // Translucent vertices of the uploaded mesh in mesher order, re-sorted into its range when the camera moves
+        std::vector<PackedVertex> translucentVertices;
+        bool sorted = false; // Range is in back to front order for sortedEye
+        // Revision the section's sort in flight was taken from, 0 if none. At most one per section,
+        // so the sort jobs never outnumber the sections.
+        uint64_t sortingRevision = 0;
+        glm::vec3 sortedEye = glm::vec3(0.0f);
+    };
+    SectionMesh meshes[SECTION_COUNT];
+    void uploadRange(uint32_t& range, const std::vector<PackedVertex>& vertices, int sectionY);
+    // Overwrites the translucent range in place, same size as the uploaded one
+    void updateTranslucentVertices(int sectionY, const std::vector<PackedVertex>& vertices);
 
     void generateBiomeFeatures(int margin, float treshold, int xOffset, int zOffset, std::string structureName, int allowedBlockID);
 
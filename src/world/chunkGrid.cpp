@@ -0,0 +1,44 @@
+#include "chunkGrid.hpp"
+#include "chunk.hpp"
+
+ChunkGrid::ChunkGrid(int radius)
+    : radius(radius), size(2 * radius + 1), count(0), slots(size * size) {}
+
+bool ChunkGrid::insert(Chunk* chunk) {
+    Slot& slot = slots[slotIndex(chunk->chunkX, chunk->chunkZ)];
+    if (slot.chunk) return false;
+
+    slot.x = chunk->chunkX;
+    slot.z = chunk->chunkZ;
+    slot.chunk = chunk;
+    count++;
+    return true;
+}
+
+Chunk* ChunkGrid::remove(int x, int z) {
+    Slot& slot = slots[slotIndex(x, z)];
+    if (!slot.chunk || slot.x != x || slot.z != z) return nullptr;
+
+    Chunk* chunk = slot.chunk;
+    slot.chunk = nullptr;
+    count--;
+    return chunk;
+}
+
+void ChunkGrid::resize(int newRadius, std::vector<Chunk*>& evicted) {
+    if (newRadius == radius) return;
+
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(slots);
+
+    radius = newRadius;
+    size = 2 * radius + 1;
+    count = 0;
+    slots.assign(size * size, Slot());
+
+    for (const Slot& slot : oldSlots) {
+        if (slot.chunk && !insert(slot.chunk)) {
+            evicted.push_back(slot.chunk);
+        }
+    }
+}
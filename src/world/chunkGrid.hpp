@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+class Chunk;
+
+// Square ring buffer of chunk slots, chunk (x, z) lives in slot (x mod N, z mod N).
+// Loaded chunks always form a square of side 2 * radius + 1 around the player, so with
+// N = 2 * radius + 1 no two of them share a slot. Each slot keeps the coordinates of
+// its chunk as a tag so a lookup never has to touch the chunk itself.
+class ChunkGrid {
+public:
+    struct Slot {
+        int x = 0, z = 0;
+        Chunk* chunk = nullptr;
+    };
+
+    explicit ChunkGrid(int radius = 0);
+
+    Chunk* get(int x, int z) const {
+        const Slot& slot = slots[slotIndex(x, z)];
+        return (slot.chunk && slot.x == x && slot.z == z) ? slot.chunk : nullptr;
+    }
+
+    // False if the slot is taken by another chunk
+    bool insert(Chunk* chunk);
+    // Returns the removed chunk, nullptr if it wasn't there
+    Chunk* remove(int x, int z);
+
+    // Rebuilds the grid for a new radius, chunks that no longer fit are returned in evicted
+    void resize(int radius, std::vector<Chunk*>& evicted);
+
+    int getRadius() const { return radius; }
+    int getCount() const { return count; }
+    const std::vector<Slot>& getSlots() const { return slots; }
+
+private:
+    int radius;
+    int size; // Slots per side
+    int count;
+    std::vector<Slot> slots;
+
+    int slotIndex(int x, int z) const {
+        int sx = x % size;
+        int sz = z % size;
+        if (sx < 0) sx += size;
+        if (sz < 0) sz += size;
+        return sz * size + sx;
+    }
+};
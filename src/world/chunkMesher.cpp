@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <glm/glm.hpp>
+#include "chunkMesher.hpp"
+#include "blockDB.hpp"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Visible faces of a section as bitmasks: bit x of bits[face][y][z] is set when the face of
+// block (x, y, z) has to be drawn (the border holds the neighbouring blocks, air above and below
+// the world). Computed from per row occupancy bits with shifts and and-nots for all blocks at
+// once, instead of six neighbour lookups per block.
+struct FaceMasks {
+    uint16_t bits[6][SectionSnapshot::SIZE][SectionSnapshot::SIZE];
+};
+
+// Bits of a padded row where a and b hold the same block
+static uint32_t getEqualBits(const uint8_t* a, const uint8_t* b) {
+    uint32_t bits = 0;
+    for (int i = 0; i < SectionSnapshot::PADDED; ++i) {
+        bits |= uint32_t(a[i] == b[i]) << i;
+    }
+    return bits;
+}
+
+static void buildFaceMasks(const SectionSnapshot& snapshot, FaceMasks& masks) {
+    const int SIZE = SectionSnapshot::SIZE;
+    const int PADDED = SectionSnapshot::PADDED;
+
+    // Solid and opaque bits of every padded row along x: bit x + 1 for block x, bits 0 and
+    // SIZE + 1 are the left and right border. Indexed [y + 1][z + 1].
+    uint32_t solidRows[PADDED][PADDED];
+    uint32_t opaqueRows[PADDED][PADDED];
+    for (int y = 0; y < PADDED; ++y) {
+        for (int z = 0; z < PADDED; ++z) {
+            const uint8_t* src = snapshot.blocks + (y * PADDED + z) * PADDED;
+            uint32_t solid = 0, opaque = 0;
+            for (int i = 0; i < PADDED; ++i) {
+                solid |= uint32_t(src[i] != 0) << i;
+                opaque |= uint32_t(BlockDB::isOpaque(src[i])) << i;
+            }
+            solidRows[y][z] = solid;
+            opaqueRows[y][z] = opaque;
+        }
+    }
+
+    for (int y = 0; y < SIZE; ++y) {
+        for (int z = 0; z < SIZE; ++z) {
+            uint32_t opaque = opaqueRows[y + 1][z + 1];
+            uint32_t translucent = solidRows[y + 1][z + 1] & ~opaque;
+
+            // Neighbours hiding the face, per face: 0 front (+z), 1 back (-z), 2 left (-x), 3 right (+x), 4 top, 5 bottom
+            uint32_t hiding[6] = {
+                opaqueRows[y + 1][z + 2], opaqueRows[y + 1][z],
+                opaque << 1, opaque >> 1,
+                opaqueRows[y + 2][z + 1], opaqueRows[y][z + 1]
+            };
+            uint32_t visible[6];
+            for (int face = 0; face < 6; ++face) {
+                visible[face] = opaque & ~hiding[face];
+            }
+
+            // Transparent blocks also hide the faces between blocks of their own type
+            if (translucent != 0) {
+                const uint8_t* row = &snapshot.blocks[((y + 1) * PADDED + (z + 1)) * PADDED];
+                uint32_t sameAsNext = getEqualBits(row, row + 1);
+                uint32_t same[6] = {
+                    getEqualBits(row, row + PADDED), getEqualBits(row, row - PADDED),
+                    sameAsNext << 1, sameAsNext,
+                    getEqualBits(row, row + PADDED * PADDED), getEqualBits(row, row - PADDED * PADDED)
+                };
+                for (int face = 0; face < 6; ++face) {
+                    visible[face] |= translucent & ~(hiding[face] | same[face]);
+                }
+            }
+
+            for (int face = 0; face < 6; ++face) {
+                masks.bits[face][y][z] = static_cast<uint16_t>(visible[face] >> 1);
+            }
+        }
+    }
+}
+
+// Index of the lowest set bit, bits must not be 0
+static int lowestBit(uint32_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+static void addFace(std::vector<PackedVertex>& vertices, int x, int y, int z, int face, const BlockDB::BlockInfo* blockInfo,
+                    int width = 1, int height = 1) {
+    static const glm::ivec3 faceVertices[6][4] = {
+        {{0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}}, // Front
+        {{1,0,0}, {0,0,0}, {0,1,0}, {1,1,0}}, // Back
+        {{0,0,0}, {0,0,1}, {0,1,1}, {0,1,0}}, // Left
+        {{1,0,1}, {1,0,0}, {1,1,0}, {1,1,1}}, // Right
+        {{0,1,1}, {1,1,1}, {1,1,0}, {0,1,0}}, // Top
+        {{0,0,0}, {1,0,0}, {1,0,1}, {0,0,1}}  // Bottom
+    };
+
+    // Size of the quad along x, y, z (width runs along the face's u axis, height along v)
+    glm::ivec3 size;
+    switch (face) {
+        case 0: case 1: size = glm::ivec3(width, height, 1); break; // Front/back
+        case 2: case 3: size = glm::ivec3(1, height, width); break; // Left/right
+        default:        size = glm::ivec3(width, 1, height); break; // Top/bottom
+    }
+
+    // The shader rebuilds the uv from the corner and quad size, in tile units so merged quads repeat the tile
+    const glm::vec2& tile = blockInfo->textureCoords[face];
+    int tileIndex = static_cast<int>(tile.y) * 16 + static_cast<int>(tile.x);
+
+    for (int i = 0; i < 4; ++i) {
+        glm::ivec3 pos = faceVertices[face][i] * size + glm::ivec3(x, y, z);
+        vertices.push_back(PackedVertex::pack(pos.x, pos.y, pos.z, face, i, tileIndex, width, height));
+    }
+}
+
+// Blended blocks go to the translucent pass, cutout ones stay in the opaque pass
+static std::vector<PackedVertex>& getPassVertices(SectionMeshData& mesh, const BlockDB::BlockInfo* blockInfo) {
+    return blockInfo->isBlended() ? mesh.translucent : mesh.opaque;
+}
+
+static void buildPerFaceGeometry(const SectionSnapshot& snapshot, const FaceMasks& masks, SectionMeshData& mesh) {
+    for (int y = 0; y <= snapshot.topY; ++y) {
+        for (int z = 0; z < SectionSnapshot::SIZE; ++z) {
+            for (int face = 0; face < 6; ++face) {
+                // Only the blocks with this face visible
+                for (uint32_t bits = masks.bits[face][y][z]; bits != 0; bits &= bits - 1) {
+                    int x = lowestBit(bits);
+                    const BlockDB::BlockInfo* info = BlockDB::getBlockInfo(snapshot.get(x, y, z));
+                    if (info) {
+                        addFace(getPassVertices(mesh, info), x, y, z, face, info);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void buildGreedyGeometry(const SectionSnapshot& snapshot, const FaceMasks& masks, SectionMeshData& mesh) {
+    // Each face is swept slice by slice along its normal. Within a slice, the face plane is
+    // described by a "u" axis (quad width) and a "v" axis (quad height), matching the
+    // uv directions used by addFace.
+    // Axis indices: 0 = x, 1 = y, 2 = z
+    static const int normalAxis[6] = {2, 2, 0, 0, 1, 1};
+    static const int uAxis[6]      = {0, 0, 2, 2, 0, 0};
+    static const int vAxis[6]      = {1, 1, 1, 1, 2, 2};
+    const int dims[3] = {SectionSnapshot::SIZE, snapshot.topY + 1, SectionSnapshot::SIZE};
+
+    // Mask cell key = atlas tile index + 1 of a visible face (+ 256 in the translucent pass), 0 = no face
+    struct MaskCell {
+        const BlockDB::BlockInfo* info;
+        int key;
+    };
+    MaskCell mask[SectionSnapshot::SIZE * SectionSnapshot::SIZE];
+
+    for (int face = 0; face < 6; ++face) {
+        const int n = normalAxis[face];
+        const int u = uAxis[face];
+        const int v = vAxis[face];
+        const int uSize = dims[u];
+        const int vSize = dims[v];
+
+        // Slices with at least one visible face, bit per slice
+        uint32_t slicesWithFaces = 0;
+        for (int y = 0; y < dims[1]; ++y) {
+            for (int z = 0; z < SectionSnapshot::SIZE; ++z) {
+                uint32_t bits = masks.bits[face][y][z];
+                if (bits == 0) continue;
+                if (n == 0) slicesWithFaces |= bits;
+                else slicesWithFaces |= 1u << (n == 1 ? y : z);
+            }
+        }
+
+        for (int slice = 0; slice < dims[n]; ++slice) {
+            if ((slicesWithFaces & (1u << slice)) == 0) continue;
+
+            // Build mask of visible faces for this slice
+            bool anyFace = false;
+            for (int j = 0; j < vSize; ++j) {
+                for (int i = 0; i < uSize; ++i) {
+                    int pos[3];
+                    pos[n] = slice;
+                    pos[u] = i;
+                    pos[v] = j;
+
+                    MaskCell& cell = mask[j * uSize + i];
+                    cell = {nullptr, 0};
+                    if ((masks.bits[face][pos[1]][pos[2]] & (1u << pos[0])) == 0) continue;
+
+                    const BlockDB::BlockInfo* info = BlockDB::getBlockInfo(snapshot.get(pos[0], pos[1], pos[2]));
+                    if (!info) continue;
+
+                    // Faces merge when they sample the same atlas tile in the same pass
+                    const glm::vec2& tile = info->textureCoords[face];
+                    cell = {info, static_cast<int>(tile.y) * 16 + static_cast<int>(tile.x) + 1 + (info->isBlended() ? 256 : 0)};
+                    anyFace = true;
+                }
+            }
+            if (!anyFace) continue;
+
+            // Merge the mask into rectangles
+            for (int j = 0; j < vSize; ++j) {
+                for (int i = 0; i < uSize;) {
+                    const MaskCell cell = mask[j * uSize + i];
+                    if (cell.key == 0) {
+                        ++i;
+                        continue;
+                    }
+
+                    int width = 1;
+                    while (i + width < uSize && mask[j * uSize + i + width].key == cell.key)
+                        ++width;
+
+                    int height = 1;
+                    bool canGrow = true;
+                    while (j + height < vSize && canGrow) {
+                        for (int k = 0; k < width; ++k) {
+                            if (mask[(j + height) * uSize + i + k].key != cell.key) {
+                                canGrow = false;
+                                break;
+                            }
+                        }
+                        if (canGrow) ++height;
+                    }
+
+                    int pos[3];
+                    pos[n] = slice;
+                    pos[u] = i;
+                    pos[v] = j;
+                    addFace(getPassVertices(mesh, cell.info), pos[0], pos[1], pos[2], face, cell.info, width, height);
+
+                    for (int h = 0; h < height; ++h) {
+                        for (int k = 0; k < width; ++k) {
+                            mask[(j + h) * uSize + i + k].key = 0;
+                        }
+                    }
+                    i += width;
+                }
+            }
+        }
+    }
+}
+
+void buildSectionMesh(const SectionSnapshot& snapshot, Chunk::MeshingMode mode, SectionMeshData& mesh) {
+    auto meshStart = std::chrono::steady_clock::now();
+
+    mesh.opaque.clear();
+    mesh.translucent.clear();
+
+    FaceMasks masks;
+    buildFaceMasks(snapshot, masks);
+
+    if (mode == Chunk::MeshingMode::Greedy)
+        buildGreedyGeometry(snapshot, masks, mesh);
+    else
+        buildPerFaceGeometry(snapshot, masks, mesh);
+
+    mesh.vertexCount = mesh.opaque.size() + mesh.translucent.size();
+    mesh.meshTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - meshStart).count();
+}
+
+void sortQuadsBackToFront(const std::vector<PackedVertex>& vertices, const glm::vec3& eye,
+                          std::vector<uint64_t>& keys, std::vector<PackedVertex>& sorted) {
+    // Quad centres are the sum of two opposite corners (in half blocks), so is the eye here
+    const glm::vec3 eye2 = eye * 2.0f;
+    const size_t quadCount = vertices.size() / 4;
+
+    // Squared distance in the high half of the key: positive floats order like their bits
+    keys.resize(quadCount);
+    for (size_t quad = 0; quad < quadCount; ++quad) {
+        const PackedVertex& corner0 = vertices[quad * 4];
+        const PackedVertex& corner2 = vertices[quad * 4 + 2];
+        glm::vec3 offset = glm::vec3(corner0.getX() + corner2.getX(), corner0.getY() + corner2.getY(),
+                                     corner0.getZ() + corner2.getZ()) - eye2;
+        float distance = glm::dot(offset, offset);
+        uint32_t distanceBits;
+        memcpy(&distanceBits, &distance, sizeof(distanceBits));
+        keys[quad] = uint64_t(distanceBits) << 32 | quad;
+    }
+    std::sort(keys.begin(), keys.end(), [](uint64_t a, uint64_t b) { return a > b; });
+
+    sorted.resize(quadCount * 4);
+    PackedVertex* out = sorted.data();
+    for (uint64_t key : keys) {
+        const PackedVertex* quad = &vertices[(key & 0xffffffffu) * 4];
+        std::copy(quad, quad + 4, out);
+        out += 4;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "chunk.hpp"
+
+// Copy of one section's blocks plus a one block border: the neighbour chunks' edges
+// and the layers above and below. This is everything the mesher reads, so meshing
+// can run on any thread.
+struct SectionSnapshot {
+    static const int SIZE = ChunkSection::SIZE;
+    static const int PADDED = SIZE + 2;
+
+    int chunkX, chunkZ, sectionY;
+    int topY; // Highest layer of the section with blocks (from the chunk's max height), all air above
+    uint8_t blocks[PADDED * PADDED * PADDED];
+
+    // Coordinates range from -1 to SIZE (the border)
+    uint8_t get(int x, int y, int z) const {
+        return blocks[((y + 1) * PADDED + (z + 1)) * PADDED + (x + 1)];
+    }
+    void set(int x, int y, int z, uint8_t type) {
+        blocks[((y + 1) * PADDED + (z + 1)) * PADDED + (x + 1)] = type;
+    }
+};
+
+// 8 byte vertex with integer fields, decoded by shaders/vertex.glsl:
+//   lo: x | y << 5 | z << 10 | face << 15 | corner << 18 | atlas tile << 20
+//   hi: quad width | quad height << 5
+// Positions (0 to 16) are relative to the section origin, corner is the quad corner (0 to 3)
+// the uv comes from, atlas tile is tile.y * 16 + tile.x and the quad size in blocks repeats
+// the tile over merged quads.
+struct PackedVertex {
+    uint32_t lo, hi;
+
+    static PackedVertex pack(int x, int y, int z, int face, int corner, int tile, int width, int height) {
+        return {
+            uint32_t(x) | uint32_t(y) << 5 | uint32_t(z) << 10 | uint32_t(face) << 15 | uint32_t(corner) << 18 | uint32_t(tile) << 20,
+            uint32_t(width) | uint32_t(height) << 5
+        };
+    }
+    int getX() const { return lo & 31; }
+    int getY() const { return (lo >> 5) & 31; }
+    int getZ() const { return (lo >> 10) & 31; }
+    int getFace() const { return (lo >> 15) & 7; }
+    int getCorner() const { return (lo >> 18) & 3; }
+    int getTile() const { return (lo >> 20) & 255; }
+    int getWidth() const { return hi & 31; }
+    int getHeight() const { return (hi >> 5) & 31; }
+};
+
+// CPU side mesh of a section, uploaded to the GPU by Chunk::uploadMesh. Vertices only, 4 per
+// quad: every quad is drawn with the same index pattern (see VertexArena).
+struct SectionMeshData {
+    std::vector<PackedVertex> opaque;      // Depth tested and written, drawn first (cutout blocks like leaves too)
+    std::vector<PackedVertex> translucent; // Blended transparent blocks (water, lava), drawn over the opaque pass
+    size_t vertexCount = 0;                // Both passes
+    float meshTimeMs = 0.0f;
+
+    // Room for most sections up front, buffers that get reused then rarely have to grow
+    static const size_t TYPICAL_VERTICES = 4096;
+    void reserveTypical() {
+        opaque.reserve(TYPICAL_VERTICES);
+        translucent.reserve(TYPICAL_VERTICES / 4);
+    }
+};
+
+// Writes the quads of vertices to sorted from the farthest to the nearest as seen from eye,
+// relative to the section origin. keys is scratch, sorted is replaced; neither allocates
+// once they have grown to the section's quad count.
+void sortQuadsBackToFront(const std::vector<PackedVertex>& vertices, const glm::vec3& eye,
+                          std::vector<uint64_t>& keys, std::vector<PackedVertex>& sorted);
+
+// Faces are culled by opacity class: a face is hidden behind an opaque block, and between two
+// transparent blocks of the same type (so water inside an ocean has no faces).
+// Replaces mesh's contents, keeping the capacity of its buffers: meshing into the same
+// SectionMeshData again doesn't allocate unless the mesh is bigger than any before
+void buildSectionMesh(const SectionSnapshot& snapshot, Chunk::MeshingMode mode, SectionMeshData& mesh);
@@ -0,0 +1,144 @@
+#include "chunkSection.hpp"
+
+ChunkSection::ChunkSection() {
+    fill(0); // Air
+}
+
+void ChunkSection::setBits(int bits) {
+    bitsPerBlock = bits;
+    if (bits == 0) {
+        wordShift = 0;
+        indicesPerWordMask = 0;
+        indexMask = 0;
+        return;
+    }
+
+    int indicesPerWord = 64 / bits;
+    wordShift = 0;
+    while ((1 << wordShift) < indicesPerWord) ++wordShift;
+    indicesPerWordMask = indicesPerWord - 1;
+    indexMask = (uint64_t(1) << bits) - 1;
+}
+
+void ChunkSection::fill(uint8_t type) {
+    palette.assign(1, type);
+    nonAirCount = (type != 0) ? VOLUME : 0;
+    data.clear();
+    data.shrink_to_fit();
+    setBits(0);
+}
+
+void ChunkSection::assign(const uint8_t* blocks) {
+    // Palette in order of first appearance
+    int paletteIndex[256];
+    for (int& index : paletteIndex) index = -1;
+    palette.clear();
+    nonAirCount = 0;
+    for (int i = 0; i < VOLUME; ++i) {
+        uint8_t type = blocks[i];
+        if (paletteIndex[type] < 0) {
+            paletteIndex[type] = static_cast<int>(palette.size());
+            palette.push_back(type);
+        }
+        nonAirCount += (type != 0);
+    }
+
+    if (palette.size() == 1) {
+        fill(palette[0]);
+        return;
+    }
+
+    int bits = 1;
+    while ((size_t(1) << bits) < palette.size()) bits *= 2;
+    setBits(bits);
+
+    // Pack whole words at a time
+    int indicesPerWord = indicesPerWordMask + 1;
+    data.assign(VOLUME * bits / 64, 0);
+    for (size_t word = 0; word < data.size(); ++word) {
+        uint64_t packed = 0;
+        const uint8_t* src = blocks + word * indicesPerWord;
+        for (int i = 0; i < indicesPerWord; ++i) {
+            packed |= uint64_t(paletteIndex[src[i]]) << (i * bits);
+        }
+        data[word] = packed;
+    }
+}
+
+void ChunkSection::writeIndex(int i, uint32_t paletteIndex) {
+    int shift = (i & indicesPerWordMask) * bitsPerBlock;
+    uint64_t& word = data[i >> wordShift];
+    word = (word & ~(indexMask << shift)) | (uint64_t(paletteIndex) << shift);
+}
+
+void ChunkSection::resize(int newBits) {
+    // Repack every index with the new width
+    std::vector<uint32_t> indices(VOLUME, 0);
+    if (bitsPerBlock != 0) {
+        for (int i = 0; i < VOLUME; ++i) {
+            int shift = (i & indicesPerWordMask) * bitsPerBlock;
+            indices[i] = static_cast<uint32_t>((data[i >> wordShift] >> shift) & indexMask);
+        }
+    }
+
+    setBits(newBits);
+    data.assign(VOLUME * newBits / 64, 0);
+    for (int i = 0; i < VOLUME; ++i) {
+        if (indices[i] != 0) writeIndex(i, indices[i]);
+    }
+}
+
+void ChunkSection::set(int x, int y, int z, uint8_t type) {
+    uint8_t oldType = get(x, y, z);
+    if (oldType == type) return;
+    nonAirCount += (type != 0) - (oldType != 0);
+    if (nonAirCount == 0) {
+        // Last block dug out, go back to a uniform air section
+        fill(0);
+        return;
+    }
+
+    uint32_t paletteIndex = 0;
+    while (paletteIndex < palette.size() && palette[paletteIndex] != type) ++paletteIndex;
+
+    if (paletteIndex == palette.size()) {
+        // New block type, widen the indices if the palette is full
+        if (palette.size() >= (size_t(1) << bitsPerBlock)) {
+            resize(bitsPerBlock == 0 ? 1 : bitsPerBlock * 2);
+        }
+        palette.push_back(type);
+    }
+
+    writeIndex(index(x, y, z), paletteIndex);
+}
+
+void ChunkSection::setRun(int x, int y, int z, int length, uint8_t type) {
+    if (type == 0) {
+        // Air can empty the section, set handles that
+        for (int i = 0; i < length; ++i) set(x + i, y, z, 0);
+        return;
+    }
+    if (bitsPerBlock == 0 && palette[0] == type) return;
+
+    uint32_t paletteIndex = 0;
+    while (paletteIndex < palette.size() && palette[paletteIndex] != type) ++paletteIndex;
+
+    if (paletteIndex == palette.size()) {
+        if (palette.size() >= (size_t(1) << bitsPerBlock)) {
+            resize(bitsPerBlock == 0 ? 1 : bitsPerBlock * 2);
+        }
+        palette.push_back(type);
+    }
+
+    int start = index(x, y, z);
+    for (int i = start; i < start + length; ++i) {
+        int shift = (i & indicesPerWordMask) * bitsPerBlock;
+        uint32_t oldIndex = static_cast<uint32_t>((data[i >> wordShift] >> shift) & indexMask);
+        nonAirCount += (palette[oldIndex] == 0);
+        writeIndex(i, paletteIndex);
+    }
+}
+
+size_t ChunkSection::getMemoryUsage() const {
+    return sizeof(ChunkSection) + palette.capacity() * sizeof(uint8_t) + data.capacity() * sizeof(uint64_t);
+}
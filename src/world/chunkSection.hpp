@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// 16x16x16 blocks stored as a palette of block types plus bit-packed palette indices.
+// A section holding a single block type (all air, all stone) has no per-block data,
+// otherwise indices take 1, 2, 4 or 8 bits depending on how many types it contains.
+class ChunkSection {
+public:
+    static const int SIZE = 16;
+    static const int VOLUME = SIZE * SIZE * SIZE;
+
+    ChunkSection();
+
+    uint8_t get(int x, int y, int z) const {
+        if (bitsPerBlock == 0) return palette[0];
+        int i = index(x, y, z);
+        int shift = (i & indicesPerWordMask) * bitsPerBlock;
+        return palette[(data[i >> wordShift] >> shift) & indexMask];
+    }
+    void set(int x, int y, int z, uint8_t type);
+    // Sets length blocks from (x, y, z) along +x, the palette is looked up once for the whole run
+    void setRun(int x, int y, int z, int length, uint8_t type);
+
+    // Replaces every block, dropping the per-block data
+    void fill(uint8_t type);
+    // Replaces every block with VOLUME types in (y * SIZE + z) * SIZE + x order, packing them in one pass
+    void assign(const uint8_t* blocks);
+
+    bool isUniform() const { return bitsPerBlock == 0; }
+    bool isEmpty() const { return nonAirCount == 0; }
+    int getNonAirCount() const { return nonAirCount; }
+    int getBitsPerBlock() const { return bitsPerBlock; }
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<uint8_t> palette;  // Palette index -> block type
+    std::vector<uint64_t> data;    // Packed palette indices, empty when uniform
+    int bitsPerBlock;              // 0, 1, 2, 4 or 8
+    int nonAirCount;
+
+    // Derived from bitsPerBlock, indices never straddle two words
+    int wordShift;                 // log2(indices per word)
+    int indicesPerWordMask;
+    uint64_t indexMask;
+
+    static int index(int x, int y, int z) { return (y * SIZE + z) * SIZE + x; }
+    void setBits(int bits);
+    void resize(int newBits);
+    void writeIndex(int i, uint32_t paletteIndex);
+};
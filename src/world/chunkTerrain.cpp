@@ -1,6 +1,11 @@
-#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include "structureDB.hpp"
 #include "noise.hpp"
+#include "caveDensity.hpp"
 #include "chunkTerrain.hpp"
 
 // Helper function to get biome based on noise value
@@ -37,197 +42,506 @@ void getBiomeParams(Chunk::Biome biome, float& heightScale, float& detailWeight,
     }
 }
 
-void generateChunkTerrain(Chunk& chunk) {
-    const int WIDTH = Chunk::WIDTH;
-    const int HEIGHT = Chunk::HEIGHT;
-    const int DEPTH = Chunk::DEPTH;
-    auto& noises = chunk.noises;
-    int chunkX = chunk.chunkX;
-    int chunkZ = chunk.chunkZ;
-    const int transitionRadius = 5; // blend over 5 blocks
+// Vertical runs of one block type in a column, later runs overwrite earlier ones
+struct ColumnLayers {
+    struct Span { int bottom, top; uint8_t type; };
+    Span spans[5];
+    int count = 0;
+
+    // Clipped to y 0..HEIGHT-1, empty runs are dropped
+    void add(int bottom, int top, uint8_t type) {
+        bottom = std::max(bottom, 0);
+        top = std::min(top, Chunk::HEIGHT - 1);
+        if (bottom <= top) spans[count++] = {bottom, top, type};
+    }
+};
 
+// Distorted cellular biome noise at count points, the most expensive noise we sample
+static void sampleBiomeNoise(const ChunkNoises& noises, const float* x, const float* z, float* out, int count) {
     // Distortion strength for biome edges
     const float biomeDistortStrength = 8.0f;
+    const int MAX_COUNT = Chunk::WIDTH * Chunk::DEPTH;
+
+    float offsetX[MAX_COUNT], offsetZ[MAX_COUNT];
+    float distortX[MAX_COUNT], distortY[MAX_COUNT];
+    for (int i = 0; i < count; ++i) {
+        offsetX[i] = x[i] + 1000.0f;
+        offsetZ[i] = z[i] + 1000.0f;
+    }
+
+    // Distort biome noise coordinates
+    noises.biomeDistortNoise.getNoise(x, z, distortX, count);
+    noises.biomeDistortNoise.getNoise(offsetX, offsetZ, distortY, count);
+    for (int i = 0; i < count; ++i) {
+        distortX[i] = x[i] + distortX[i] * biomeDistortStrength;
+        distortY[i] = z[i] + distortY[i] * biomeDistortStrength;
+    }
+    noises.biomeNoise.getNoise(distortX, distortY, out, count);
+}
+
+void generateTerrainColumns(const GeneratorContext& generator, int chunkX, int chunkZ, Chunk::Biome* biomes, float* heights) {
+    const int WIDTH = Chunk::WIDTH;
+    const int DEPTH = Chunk::DEPTH;
+    const int COLUMNS = WIDTH * DEPTH;
+    const ChunkNoises& noises = generator.noises;
+
+    // Noise inputs and outputs, evaluated in batches
+    float columnX[COLUMNS], columnZ[COLUMNS];
+    float biomeValues[COLUMNS], baseValues[COLUMNS], detailValues[COLUMNS], detail2Values[COLUMNS];
+
+    for (int x = 0; x < WIDTH; ++x) {
+        for (int z = 0; z < DEPTH; ++z) {
+            int i = x * DEPTH + z;
+            columnX[i] = (float)(chunkX * WIDTH + x);
+            columnZ[i] = (float)(chunkZ * DEPTH + z);
+        }
+    }
+
+    if (generator.coarseBiomes) {
+        // Biome noise only at the centre of each 4x4 block of columns, the whole block takes that biome
+        const int BLOCK = GeneratorContext::BIOME_BLOCK;
+        const int LATTICE_DEPTH = DEPTH / BLOCK;
+        const int LATTICE_POINTS = (WIDTH / BLOCK) * LATTICE_DEPTH;
+        float latticeX[LATTICE_POINTS], latticeZ[LATTICE_POINTS], latticeValues[LATTICE_POINTS];
+        for (int i = 0; i < LATTICE_POINTS; ++i) {
+            latticeX[i] = (float)(chunkX * WIDTH + (i / LATTICE_DEPTH) * BLOCK + BLOCK / 2);
+            latticeZ[i] = (float)(chunkZ * DEPTH + (i % LATTICE_DEPTH) * BLOCK + BLOCK / 2);
+        }
+        sampleBiomeNoise(noises, latticeX, latticeZ, latticeValues, LATTICE_POINTS);
+
+        for (int x = 0; x < WIDTH; ++x) {
+            for (int z = 0; z < DEPTH; ++z) {
+                biomeValues[x * DEPTH + z] = latticeValues[(x / BLOCK) * LATTICE_DEPTH + z / BLOCK];
+            }
+        }
+    } else {
+        sampleBiomeNoise(noises, columnX, columnZ, biomeValues, COLUMNS);
+    }
+
+    noises.baseNoise.getNoise(columnX, columnZ, baseValues, COLUMNS);
+    noises.detailNoise.getNoise(columnX, columnZ, detailValues, COLUMNS);
+    noises.detail2Noise.getNoise(columnX, columnZ, detail2Values, COLUMNS);
+
+    for (int i = 0; i < COLUMNS; ++i) {
+        Chunk::Biome biome = getBiome(biomeValues[i]);
+        biomes[i] = biome;
+
+        float base = baseValues[i] * 0.5f + 0.5f;
+        float detail = detailValues[i] * 0.5f + 0.5f;
+        float detail2 = detail2Values[i] * 0.5f + 0.5f;
+
+        float heightScale = 1.0f;
+        float detailWeight = 1.0f;
+        float power = 1.3f;
+        float baseHeight = 30.0f;
+        getBiomeParams(biome, heightScale, detailWeight, power, baseHeight);
+
+        float combined = base + detail * detailWeight + detail2 * 0.2f;
+        combined = std::pow(combined, power);
+        heights[i] = combined * 24.0f * heightScale + baseHeight;
+    }
+}
 
-    // Get the "main" biome for this chunk for feature generation
-    float b = noises.biomeNoise.GetNoise(
-        (float)(chunkX * WIDTH) + noises.biomeDistortNoise.GetNoise((float)(chunkX * WIDTH), (float)(chunkZ * DEPTH)) * biomeDistortStrength,
-        (float)(chunkZ * DEPTH) + noises.biomeDistortNoise.GetNoise((float)(chunkX * WIDTH) + 1000.0f, (float)(chunkZ * DEPTH) + 1000.0f) * biomeDistortStrength
-    );
-    Chunk::Biome biome = getBiome(b);
-
-    // Precompute biome and height values for the blending to avoid redundant noise calls
-    std::vector<std::vector<Chunk::Biome>> biomeCache(WIDTH + 2 * transitionRadius, std::vector<Chunk::Biome>(DEPTH + 2 * transitionRadius));
-    std::vector<std::vector<float>> heightCache(WIDTH + 2 * transitionRadius, std::vector<float>(DEPTH + 2 * transitionRadius));
-
-    for (int dx = -transitionRadius; dx < WIDTH + transitionRadius; ++dx) {
-        for (int dz = -transitionRadius; dz < DEPTH + transitionRadius; ++dz) {
-            int wx = chunkX * WIDTH + dx;
-            int wz = chunkZ * DEPTH + dz;
-
-            // Distort biome noise coordinates
-            float distortX = noises.biomeDistortNoise.GetNoise((float)wx, (float)wz) * biomeDistortStrength;
-            float distortY = noises.biomeDistortNoise.GetNoise((float)wx + 1000.0f, (float)wz + 1000.0f) * biomeDistortStrength;
-            float biomeNoise = noises.biomeNoise.GetNoise((float)wx + distortX, (float)wz + distortY);
-            Chunk::Biome biome = getBiome(biomeNoise);
-            biomeCache[dx + transitionRadius][dz + transitionRadius] = biome;
-
-            float base = noises.baseNoise.GetNoise((float)wx, (float)wz) * 0.5f + 0.5f;
-            float detail = noises.detailNoise.GetNoise((float)wx, (float)wz) * 0.5f + 0.5f;
-            float detail2 = noises.detail2Noise.GetNoise((float)wx, (float)wz) * 0.5f + 0.5f;
-
-            float heightScale = 1.0f;
-            float detailWeight = 1.0f;
-            float power = 1.3f;
-            float baseHeight = 30.0f;
-            getBiomeParams(biome, heightScale, detailWeight, power, baseHeight);
-
-            float combined = base + detail * detailWeight + detail2 * 0.2f;
-            combined = std::pow(combined, power);
-            float height = combined * 24.0f * heightScale + baseHeight;
-            heightCache[dx + transitionRadius][dz + transitionRadius] = height;
+// Biomes blend over the 11x11 columns around each column
+static const int transitionRadius = 5; // blend over 5 blocks
+static const int BIOME_COUNT = 3;
+
+// Blend weight 1 / (1 + dx^2 + dz^2) over the 11x11 window, approximated by four nested boxes
+// (least squares fit) so each column costs a fixed number of summed-area table lookups.
+// Against the exact kernel heights differ by at most 0.48 blocks (0.06 on average), about
+// 6% of border columns end one block higher or lower and 0.1% pick another biome.
+struct BlendBox { int radius; float weight; };
+static const BlendBox blendBoxes[] = { {0, 0.58333f}, {1, 0.30449f}, {3, 0.07462f}, {transitionRadius, 0.03755f} };
+static const int BLEND_BOX_COUNT = sizeof(blendBoxes) / sizeof(blendBoxes[0]);
+
+// Heights and biome counts inside each blend box around a column. The heights are floats of
+// bounded size, so their double sums are exact in any order: every way of computing them
+// gives the same column.
+struct BlendSums {
+    double heights[BLEND_BOX_COUNT] = {};
+    int biomes[BLEND_BOX_COUNT][BIOME_COUNT] = {};
+};
+
+static float getBoxWeightSum() {
+    float sum = 0.0f;
+    for (const BlendBox& box : blendBoxes) {
+        int side = 2 * box.radius + 1;
+        sum += box.weight * side * side;
+    }
+    return sum;
+}
+
+// Final surface height and biome of a column
+static void finishBlend(const BlendSums& sums, Chunk::Biome centerBiome, float centerHeight, int& height, Chunk::Biome& biome) {
+    static const float boxWeightSum = getBoxWeightSum();
+    const int windowSide = 2 * transitionRadius + 1;
+
+    float blendedHeight = centerHeight;
+    biome = centerBiome;
+
+    // Blending, only near biome borders
+    if (sums.biomes[BLEND_BOX_COUNT - 1][static_cast<int>(centerBiome)] != windowSide * windowSide) {
+        double heightTotal = 0.0;
+        float biomeWeights[BIOME_COUNT] = {};
+        for (int k = 0; k < BLEND_BOX_COUNT; ++k) {
+            heightTotal += blendBoxes[k].weight * sums.heights[k];
+            for (int b = 0; b < BIOME_COUNT; ++b) {
+                biomeWeights[b] += blendBoxes[k].weight * sums.biomes[k][b];
+            }
+        }
+
+        blendedHeight = static_cast<float>(heightTotal / boxWeightSum);
+
+        float maxWeight = -1.0f;
+        for (int b = 0; b < BIOME_COUNT; ++b) {
+            if (biomeWeights[b] > maxWeight) {
+                maxWeight = biomeWeights[b];
+                biome = static_cast<Chunk::Biome>(b);
+            }
+        }
+    }
+
+    height = static_cast<int>(blendedHeight);
+}
+
+// Surface height and biome of all columns of a chunk, indexed [x * DEPTH + z]. mainBiome is the
+// unblended biome at the chunk origin, it picks the chunk's features.
+static void computeChunkColumns(TerrainColumnCache& columnCache, int chunkX, int chunkZ, int* heights, Chunk::Biome* biomes, Chunk::Biome& mainBiome) {
+    const int WIDTH = Chunk::WIDTH;
+    const int DEPTH = Chunk::DEPTH;
+
+    // Biome and height of the chunk's columns plus a transitionRadius border for the blending,
+    // mostly shared with the neighbours. Indexed [dx * PADDED_DEPTH + dz] from the padded corner.
+    const int PADDED_WIDTH = WIDTH + 2 * transitionRadius;
+    const int PADDED_DEPTH = DEPTH + 2 * transitionRadius;
+    Chunk::Biome biomeWindow[PADDED_WIDTH * PADDED_DEPTH];
+    float heightWindow[PADDED_WIDTH * PADDED_DEPTH];
+    columnCache.getColumns(chunkX * WIDTH - transitionRadius, chunkZ * DEPTH - transitionRadius,
+                           PADDED_WIDTH, PADDED_DEPTH, biomeWindow, heightWindow);
+
+    mainBiome = biomeWindow[transitionRadius * PADDED_DEPTH + transitionRadius];
+
+    // Summed-area tables over the window, entry (x + 1, z + 1) sums [0, x] x [0, z]
+    const int SAT_DEPTH = PADDED_DEPTH + 1;
+    const int SAT_SIZE = (PADDED_WIDTH + 1) * SAT_DEPTH;
+    double heightSums[SAT_SIZE];
+    int biomeCounts[BIOME_COUNT][SAT_SIZE];
+    for (int z = 0; z < SAT_DEPTH; ++z) {
+        heightSums[z] = 0.0;
+        for (int b = 0; b < BIOME_COUNT; ++b) biomeCounts[b][z] = 0;
+    }
+    for (int x = 0; x < PADDED_WIDTH; ++x) {
+        int row = (x + 1) * SAT_DEPTH;
+        heightSums[row] = 0.0;
+        for (int b = 0; b < BIOME_COUNT; ++b) biomeCounts[b][row] = 0;
+
+        double heightRow = 0.0;
+        int biomeRow[BIOME_COUNT] = {};
+        for (int z = 0; z < PADDED_DEPTH; ++z) {
+            int i = x * PADDED_DEPTH + z;
+            heightRow += heightWindow[i];
+            biomeRow[static_cast<int>(biomeWindow[i])]++;
+
+            heightSums[row + z + 1] = heightSums[row - SAT_DEPTH + z + 1] + heightRow;
+            for (int b = 0; b < BIOME_COUNT; ++b) {
+                biomeCounts[b][row + z + 1] = biomeCounts[b][row - SAT_DEPTH + z + 1] + biomeRow[b];
+            }
         }
     }
 
     for (int x = 0; x < WIDTH; ++x) {
         for (int z = 0; z < DEPTH; ++z) {
-            int wx = chunkX * WIDTH + x;
-            int wz = chunkZ * DEPTH + z;
-
-            // Distort biome noise coordinates for this column
-            float distortX = noises.biomeDistortNoise.GetNoise((float)wx, (float)wz) * biomeDistortStrength;
-            float distortY = noises.biomeDistortNoise.GetNoise((float)wx + 1000.0f, (float)wz + 1000.0f) * biomeDistortStrength;
-            float centerBiomeNoise = noises.biomeNoise.GetNoise((float)wx + distortX, (float)wz + distortY);
-            Chunk::Biome centerBiome = getBiome(centerBiomeNoise);
-
-            float centerHeight = heightCache[x + transitionRadius][z + transitionRadius];
-
-            // Blending
-            bool hasDifferentBiome = false;
-            for (int dx = -transitionRadius; dx <= transitionRadius && !hasDifferentBiome; ++dx) {
-                for (int dz = -transitionRadius; dz <= transitionRadius && !hasDifferentBiome; ++dz) {
-                    Chunk::Biome nBiome = biomeCache[x + dx + transitionRadius][z + dz + transitionRadius];
-                    if (nBiome != centerBiome) {
-                        hasDifferentBiome = true;
-                    }
+            BlendSums sums;
+            for (int k = 0; k < BLEND_BOX_COUNT; ++k) {
+                int radius = blendBoxes[k].radius;
+                int x0 = (x + transitionRadius - radius) * SAT_DEPTH;
+                int x1 = (x + transitionRadius + radius + 1) * SAT_DEPTH;
+                int z0 = z + transitionRadius - radius;
+                int z1 = z + transitionRadius + radius + 1;
+                sums.heights[k] = heightSums[x1 + z1] - heightSums[x0 + z1] - heightSums[x1 + z0] + heightSums[x0 + z0];
+                for (int b = 0; b < BIOME_COUNT; ++b) {
+                    sums.biomes[k][b] = biomeCounts[b][x1 + z1] - biomeCounts[b][x0 + z1] - biomeCounts[b][x1 + z0] + biomeCounts[b][x0 + z0];
                 }
             }
 
-            float blendedHeight = 0.0f;
-            Chunk::Biome finalBiome = centerBiome;
+            int center = (x + transitionRadius) * PADDED_DEPTH + z + transitionRadius;
+            finishBlend(sums, biomeWindow[center], heightWindow[center], heights[x * DEPTH + z], biomes[x * DEPTH + z]);
+        }
+    }
+}
+
+// computeChunkColumns for a single world column, adding the boxes up directly
+static void computeColumn(TerrainColumnCache& columnCache, int worldX, int worldZ, int& height, Chunk::Biome& biome) {
+    const int SIDE = 2 * transitionRadius + 1;
+    Chunk::Biome biomeWindow[SIDE * SIDE];
+    float heightWindow[SIDE * SIDE];
+    columnCache.getColumns(worldX - transitionRadius, worldZ - transitionRadius, SIDE, SIDE, biomeWindow, heightWindow);
+
+    BlendSums sums;
+    for (int k = 0; k < BLEND_BOX_COUNT; ++k) {
+        int radius = blendBoxes[k].radius;
+        for (int dx = -radius; dx <= radius; ++dx) {
+            for (int dz = -radius; dz <= radius; ++dz) {
+                int i = (dx + transitionRadius) * SIDE + dz + transitionRadius;
+                sums.heights[k] += heightWindow[i];
+                sums.biomes[k][static_cast<int>(biomeWindow[i])]++;
+            }
+        }
+    }
+
+    int center = transitionRadius * SIDE + transitionRadius;
+    finishBlend(sums, biomeWindow[center], heightWindow[center], height, biome);
+}
 
-            if (hasDifferentBiome) {
-                float totalWeight = 0.0f;
-                std::map<Chunk::Biome, float> biomeWeights;
+// Top block of a generated column before features, water covers anything below sea level
+static uint8_t getSurfaceBlock(int height, Chunk::Biome biome, int& surfaceY) {
+    surfaceY = std::max(height, 36);
+    if (height < 36) return 9; // Water
+    return (biome == Chunk::Biome::Desert) ? 4 : 1; // Sand or grass
+}
 
-                for (int dx = -transitionRadius; dx <= transitionRadius; ++dx) {
-                    for (int dz = -transitionRadius; dz <= transitionRadius; ++dz) {
-                        float dist2 = static_cast<float>(dx * dx + dz * dz);
-                        float weight = 1.0f / (dist2 + 1.0f);
+// Structure a chunk's main biome scatters over its columns
+struct FeatureRule {
+    int spacing; // One structure per spacing x spacing grid cell
+    int structure; // StructureDB ID, -1 for none
+    int xOffset, zOffset; // Anchor column inside the structure
+    uint8_t allowedBlock; // Only on top of this block
+};
 
-                        Chunk::Biome nBiome = biomeCache[x + dx + transitionRadius][z + dz + transitionRadius];
-                        float nHeight = heightCache[x + dx + transitionRadius][z + dz + transitionRadius];
+// placeChunkFeatures only looks for anchors in the 8 neighbouring chunks
+static_assert(Structure::MAX_SIZE <= Chunk::WIDTH && Structure::MAX_SIZE <= Chunk::DEPTH,
+              "structures must not reach past the chunks next to their anchor");
 
-                        biomeWeights[nBiome] += weight;
-                        blendedHeight += nHeight * weight;
-                        totalWeight += weight;
-                    }
-                }
+// With the anchor outside the footprint a structure could reach two chunks away, aborts then
+static bool checkFeatureRules(const FeatureRule* rules, int count) {
+    for (int i = 0; i < count; ++i) {
+        const FeatureRule& rule = rules[i];
+        if (rule.structure < 0) continue;
+        const Structure& structure = StructureDB::get(rule.structure);
+        if (rule.xOffset < structure.minX || rule.xOffset > structure.maxX ||
+            rule.zOffset < structure.minZ || rule.zOffset > structure.maxZ) {
+            std::cerr << "Feature anchor (" << rule.xOffset << ", " << rule.zOffset << ") is outside structure "
+                      << structure.name << std::endl;
+            std::abort();
+        }
+    }
+    return true;
+}
 
-                blendedHeight /= totalWeight;
+static const FeatureRule& getFeatureRule(Chunk::Biome biome) {
+    // Indexed by biome, names resolved on first use (StructureDB is initialized before any chunk)
+    static const FeatureRule rules[BIOME_COUNT] = {
+        {32, StructureDB::getID("tree"), 2, 2, 1},  // Plains
+        //{64, StructureDB::getID("big_test"), 19, 19, 1},
+        {8, StructureDB::getID("cactus"), 0, 0, 4}, // Desert
+        {5, StructureDB::getID("tree"), 2, 2, 1}    // Forest
+    };
+    static const bool checked = checkFeatureRules(rules, BIOME_COUNT);
+    (void)checked;
+    return rules[static_cast<int>(biome)];
+}
 
-                float maxWeight = -1.0f;
-                for (auto& [b, w] : biomeWeights) {
-                    if (w > maxWeight) {
-                        maxWeight = w;
-                        finalBiome = b;
-                    }
-                }
-            } else {
-                // No blending needed
-                blendedHeight = centerHeight;
-                finalBiome = centerBiome;
+static int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+// Mixes a feature grid cell into 32 random bits
+static uint32_t hashFeatureCell(int seed, int cellX, int cellZ) {
+    uint32_t h = static_cast<uint32_t>(seed) ^ (static_cast<uint32_t>(cellX) * 501125321u) ^ (static_cast<uint32_t>(cellZ) * 1136930381u);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Stamps every structure overlapping the chunk, including those anchored in the 8 neighbours
+// (structures are at most Structure::MAX_SIZE wide and anchored inside their footprint). Each
+// anchor chunk scatters its biome's structure on a jittered grid: one anchor at a hashed offset
+// in every grid cell, kept if it lands in that chunk.
+// Anchors only depend on the seed and the generated terrain, so each chunk finds the same ones
+// and writes only its own part.
+static void placeChunkFeatures(Chunk& chunk, const GeneratorContext& generator, TerrainColumnCache& columnCache,
+                               const int* heights, const Chunk::Biome* biomes, Chunk::Biome mainBiome, const CaveDensity* caves) {
+    const int WIDTH = Chunk::WIDTH;
+    const int DEPTH = Chunk::DEPTH;
+    const int featureSeed = generator.seed + 3;
+
+    // Same order in every chunk so overlapping structures stack the same way on both sides
+    for (int anchorChunkX = chunk.chunkX - 1; anchorChunkX <= chunk.chunkX + 1; ++anchorChunkX) {
+        for (int anchorChunkZ = chunk.chunkZ - 1; anchorChunkZ <= chunk.chunkZ + 1; ++anchorChunkZ) {
+            bool own = anchorChunkX == chunk.chunkX && anchorChunkZ == chunk.chunkZ;
+
+            Chunk::Biome featureBiome = mainBiome;
+            if (!own) {
+                float unusedHeight;
+                columnCache.getColumns(anchorChunkX * WIDTH, anchorChunkZ * DEPTH, 1, 1, &featureBiome, &unusedHeight);
             }
+            const FeatureRule& rule = getFeatureRule(featureBiome);
+            if (rule.structure < 0) continue;
+            const Structure& structure = StructureDB::get(rule.structure);
 
-            int height = static_cast<int>(blendedHeight);
-
-            for (int y = 0; y < HEIGHT; ++y) {
-                if (y == 0) {
-                    chunk.blocks[x][y][z].type = 6; // Bedrock
-                } else if (y > height) {
-                    chunk.blocks[x][y][z].type = (y < 37) ? 9 : 0; // Water or air
-                    continue;
-                } else if (y == height) {
-                    switch (finalBiome) {
-                        case Chunk::Biome::Plains:
-                        case Chunk::Biome::Forest:
-                            chunk.blocks[x][y][z].type = 1; // Grass
-                            break;
-                        case Chunk::Biome::Desert:
-                            chunk.blocks[x][y][z].type = 4; // Sand
-                            break;
-                    }
-                } else if (y >= height - 2) {
-                    switch (finalBiome) {
-                        case Chunk::Biome::Plains:
-                        case Chunk::Biome::Forest:
-                            chunk.blocks[x][y][z].type = 2; // Dirt
-                            break;
-                        case Chunk::Biome::Desert:
-                            chunk.blocks[x][y][z].type = 4; // Sand
-                            break;
+            int chunkMinX = anchorChunkX * WIDTH;
+            int chunkMinZ = anchorChunkZ * DEPTH;
+            int firstCellX = floorDiv(chunkMinX, rule.spacing);
+            int lastCellX = floorDiv(chunkMinX + WIDTH - 1, rule.spacing);
+            int firstCellZ = floorDiv(chunkMinZ, rule.spacing);
+            int lastCellZ = floorDiv(chunkMinZ + DEPTH - 1, rule.spacing);
+
+            for (int cellX = firstCellX; cellX <= lastCellX; ++cellX) {
+                for (int cellZ = firstCellZ; cellZ <= lastCellZ; ++cellZ) {
+                    uint32_t hash = hashFeatureCell(featureSeed, cellX, cellZ);
+                    int x = cellX * rule.spacing + static_cast<int>((hash & 0xffff) % rule.spacing) - chunkMinX;
+                    int z = cellZ * rule.spacing + static_cast<int>((hash >> 16) % rule.spacing) - chunkMinZ;
+                    if (x < 0 || x >= WIDTH || z < 0 || z >= DEPTH) continue; // Cell shared with another chunk
+
+                    // Structure origin in this chunk's coordinates
+                    int baseX = (anchorChunkX - chunk.chunkX) * WIDTH + x - rule.xOffset;
+                    int baseZ = (anchorChunkZ - chunk.chunkZ) * DEPTH + z - rule.zOffset;
+                    if (baseX + structure.maxX < 0 || baseX + structure.minX >= WIDTH) continue;
+                    if (baseZ + structure.maxZ < 0 || baseZ + structure.minZ >= DEPTH) continue;
+
+                    int height;
+                    Chunk::Biome columnBiome;
+                    if (own) {
+                        height = heights[x * DEPTH + z];
+                        columnBiome = biomes[x * DEPTH + z];
+                    } else {
+                        computeColumn(columnCache, chunkMinX + x, chunkMinZ + z, height, columnBiome);
                     }
-                } else if (y >= height - 4) { // Desert will have stone lower underground
-                    switch (finalBiome) {
-                        case Chunk::Biome::Plains:
-                        case Chunk::Biome::Forest:
-                            chunk.blocks[x][y][z].type = 3; // Stone
-                            break;
-                        case Chunk::Biome::Desert:
-                            chunk.blocks[x][y][z].type = 4; // Sand
-                            break;
+
+                    int surfaceY;
+                    if (getSurfaceBlock(height, columnBiome, surfaceY) != rule.allowedBlock) continue;
+
+                    // Nothing grows over a cave opening
+                    if (caves) {
+                        bool carved = own ? caves->isCarved(x, surfaceY, z)
+                                          : CaveDensity::isCarved(generator.noises, chunkMinX + x, surfaceY, chunkMinZ + z);
+                        if (carved) continue;
                     }
-                } else {
-                    chunk.blocks[x][y][z].type = 3; // Stone
+
+                    chunk.placeStructure(structure, baseX, surfaceY + 1, baseZ);
                 }
             }
         }
     }
+}
 
-    // Biome specific features
-    chunk.biome = biome;
-    switch (biome) {
-        case Chunk::Biome::Plains:
-            //generateChunkBiomeFeatures(chunk, 0, 0.9999f, 19, 19, "big_test", 1);
-            generateChunkBiomeFeatures(chunk, 0, 0.998f, 2, 2, "tree", 1);
-            break;
-        case Chunk::Biome::Forest:
-            generateChunkBiomeFeatures(chunk, 0, 0.93f, 2, 2, "tree", 1);
-            break;
-        case Chunk::Biome::Desert:
-            generateChunkBiomeFeatures(chunk, 0, 0.97f, 0, 0, "cactus", 4);
-            break;
-    }
+static float getElapsedMs(std::chrono::steady_clock::time_point& start) {
+    auto now = std::chrono::steady_clock::now();
+    float ms = std::chrono::duration<float, std::milli>(now - start).count();
+    start = now;
+    return ms;
 }
 
-void generateChunkBiomeFeatures(Chunk& chunk, int margin, float treshold, int xOffset, int zOffset, std::string structureName, int allowedBlockID) {
-    ChunkNoises noises = noiseInit();
-    const Structure* structure = StructureDB::get(structureName);
-    if (!structure) return;
+void generateChunkTerrain(Chunk& chunk, const GeneratorContext& generator, TerrainColumnCache& columnCache) {
+    const int WIDTH = Chunk::WIDTH;
+    const int HEIGHT = Chunk::HEIGHT;
+    const int DEPTH = Chunk::DEPTH;
+
+    Chunk::GenerationTimes& times = chunk.generationTimes;
+    times = Chunk::GenerationTimes();
+    auto stageStart = std::chrono::steady_clock::now();
+
+    int heights[WIDTH * DEPTH];
+    Chunk::Biome biomes[WIDTH * DEPTH];
+    Chunk::Biome mainBiome;
+    computeChunkColumns(columnCache, chunk.chunkX, chunk.chunkZ, heights, biomes, mainBiome);
+
+    // Block layers of every column, filled into the sections once all are known
+    ColumnLayers columns[WIDTH * DEPTH];
+    int tops[WIDTH * DEPTH];
+    int opaqueTops[WIDTH * DEPTH];
+    int caveCeilings[WIDTH * DEPTH];
+    int minStoneTop = HEIGHT;
+    int maxTop = 0;
+    int maxCaveCeiling = 0;
+
+    for (int i = 0; i < WIDTH * DEPTH; ++i) {
+        int height = heights[i];
+
+        // Layers from the bottom up. Desert has sand 5 deep, the rest grass over 2 dirt.
+        ColumnLayers& column = columns[i];
+        bool desert = biomes[i] == Chunk::Biome::Desert;
+        column.add(1, height - (desert ? 5 : 3), 3); // Stone
+        column.add(height - (desert ? 4 : 2), height - 1, desert ? 4 : 2); // Sand or dirt
+        column.add(height, height, desert ? 4 : 1); // Sand or grass
+        column.add(height + 1, 36, 9); // Water
+        column.add(0, 0, 6); // Bedrock, last so it wins over the others on very low columns
 
-    for (int x = margin; x < Chunk::WIDTH - margin; ++x) {
-        for (int z = margin; z < Chunk::DEPTH - margin; ++z) {
-            float fx = static_cast<float>(chunk.chunkX * Chunk::WIDTH + x);
-            float fz = static_cast<float>(chunk.chunkZ * Chunk::DEPTH + z);
-            float n = noises.featureNoise.GetNoise(fx, fz);
-            if (n > treshold) { // Chance of feature spawning
-                int y = Chunk::HEIGHT - 2;
-                while (y > 0 && chunk.blocks[x][y][z].type == 0) --y; {
-                    if (chunk.blocks[x][y][z].type == allowedBlockID) {
-                        chunk.placeStructure(*structure, x - xOffset, y + 1, z - zOffset);
+        minStoneTop = std::min(minStoneTop, height - (desert ? 5 : 3));
+        maxTop = std::max(maxTop, std::max(height, 36));
+
+        // Water is the only transparent layer, bedrock keeps every column at least 0 high
+        tops[i] = std::min(std::max(height, 36), HEIGHT - 1);
+        opaqueTops[i] = std::min(std::max(height, 0), HEIGHT - 1);
+
+        // Caves can open up on land, under water they keep a 4 block thick floor
+        caveCeilings[i] = std::min(height >= 36 ? height : height - 4, HEIGHT - 1);
+        maxCaveCeiling = std::max(maxCaveCeiling, caveCeilings[i]);
+    }
+    times.terrainMs += getElapsedMs(stageStart);
+
+    CaveDensity caves;
+    if (generator.caves) {
+        caves.sample(generator.noises, chunk.chunkX, chunk.chunkZ, maxCaveCeiling);
+        times.cavesMs += getElapsedMs(stageStart);
+    }
+
+    // Write whole sections: all stone below the lowest column's stone top, untouched (air) above
+    // the highest surface, anything in between is built span by span and packed in one go
+    uint8_t sectionBlocks[ChunkSection::VOLUME];
+    for (int sectionY = 0; sectionY < Chunk::SECTION_COUNT; ++sectionY) {
+        int bottom = sectionY * ChunkSection::SIZE;
+        int top = bottom + ChunkSection::SIZE - 1;
+        if (bottom > maxTop) break;
+        bool carve = generator.caves && caves.hasCaves(sectionY);
+        if (bottom > 0 && top <= minStoneTop && !carve) {
+            chunk.getSection(sectionY).fill(3); // Stone
+            continue;
+        }
+
+        std::memset(sectionBlocks, 0, sizeof(sectionBlocks));
+        for (int x = 0; x < WIDTH; ++x) {
+            for (int z = 0; z < DEPTH; ++z) {
+                const ColumnLayers& column = columns[x * DEPTH + z];
+                for (int i = 0; i < column.count; ++i) {
+                    const ColumnLayers::Span& span = column.spans[i];
+                    int from = std::max(span.bottom, bottom);
+                    int to = std::min(span.top, top);
+                    uint8_t* dst = sectionBlocks + ((from - bottom) * ChunkSection::SIZE + z) * ChunkSection::SIZE + x;
+                    for (int y = from; y <= to; ++y, dst += ChunkSection::SIZE * ChunkSection::SIZE) {
+                        *dst = span.type;
                     }
                 }
             }
         }
+        times.terrainMs += getElapsedMs(stageStart);
+
+        if (carve) {
+            caves.carveSection(sectionY, caveCeilings, sectionBlocks);
+            times.cavesMs += getElapsedMs(stageStart);
+        }
+        chunk.getSection(sectionY).assign(sectionBlocks);
+    }
+
+    // Land columns whose surface a cave opened up are lower now
+    if (generator.caves) {
+        for (int x = 0; x < WIDTH; ++x) {
+            for (int z = 0; z < DEPTH; ++z) {
+                int i = x * DEPTH + z;
+                if (caveCeilings[i] != tops[i] || chunk.getBlock(x, tops[i], z) != 0) continue;
+                while (tops[i] > 0 && chunk.getBlock(x, tops[i], z) == 0) --tops[i];
+                opaqueTops[i] = tops[i]; // Land columns have no water
+            }
+        }
     }
+    chunk.initHeightmaps(tops, opaqueTops);
+    times.terrainMs += getElapsedMs(stageStart);
+
+    // Biome specific features
+    chunk.biome = mainBiome;
+    placeChunkFeatures(chunk, generator, columnCache, heights, biomes, mainBiome, generator.caves ? &caves : nullptr);
+    times.featuresMs += getElapsedMs(stageStart);
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "chunk.hpp"
+#include "noise.hpp"
+#include "terrainColumnCache.hpp"
 
-void generateChunkTerrain(Chunk& chunk);
-void generateChunkBiomeFeatures(Chunk& chunk, int margin, float treshold, int xOffset, int zOffset, std::string structureName, int allowedBlockID);
+// Biome and pre-blend height of a chunk's 16x16 columns, indexed [x * DEPTH + z]
+void generateTerrainColumns(const GeneratorContext& generator, int chunkX, int chunkZ, Chunk::Biome* biomes, float* heights);
+void generateChunkTerrain(Chunk& chunk, const GeneratorContext& generator, TerrainColumnCache& columnCache);
@@ -1,36 +1,144 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
 #include "noise.hpp"
-#include "../core/options.hpp"
 
-ChunkNoises noiseInit() {
+void BatchNoise::setSeed(int seed) {
+    noise.SetSeed(seed);
+    params.seed = seed;
+}
+
+void BatchNoise::setFrequency(float frequency) {
+    noise.SetFrequency(frequency);
+    params.frequency = frequency;
+}
+
+void BatchNoise::setNoiseType(FastNoiseLite::NoiseType noiseType) {
+    noise.SetNoiseType(noiseType);
+    type = noiseType;
+}
+
+void BatchNoise::setCellularDistanceFunction(FastNoiseLite::CellularDistanceFunction distanceFunction) {
+    noise.SetCellularDistanceFunction(distanceFunction);
+    params.distanceFunction = distanceFunction;
+}
+
+void BatchNoise::setCellularReturnType(FastNoiseLite::CellularReturnType returnType) {
+    noise.SetCellularReturnType(returnType);
+    params.returnType = returnType;
+}
+
+void BatchNoise::getNoise(const float* x, const float* y, float* out, int count) const {
+    if (simd != NoiseSimd::Scalar) {
+        if (type == FastNoiseLite::NoiseType_OpenSimplex2) {
+            simplexNoiseBatch(simd, params, x, y, out, count);
+            return;
+        }
+        if (type == FastNoiseLite::NoiseType_Cellular) {
+            cellularNoiseBatch(simd, params, x, y, out, count);
+            return;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        out[i] = noise.GetNoise(x[i], y[i]);
+    }
+}
+
+void BatchNoise::getNoise(const float* x, const float* y, const float* z, float* out, int count) const {
+    if (simd != NoiseSimd::Scalar && type == FastNoiseLite::NoiseType_OpenSimplex2) {
+        simplexNoiseBatch(simd, params, x, y, z, out, count);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        out[i] = noise.GetNoise(x[i], y[i], z[i]);
+    }
+}
+
+bool BatchNoise::useSimd(NoiseSimd level) {
+    // Only these two have kernels
+    bool supported = type == FastNoiseLite::NoiseType_OpenSimplex2 || type == FastNoiseLite::NoiseType_Cellular;
+    simd = supported ? level : NoiseSimd::Scalar;
+    if (simd == NoiseSimd::Scalar) return true;
+
+    // World coordinates near and far from the origin, on and off whole numbers, both signs.
+    // The odd count leaves a partial vector at the end.
+    const int count = 4099;
+    std::vector<float> x(count), y(count), z(count), simdOut(count), scalarOut(count);
+    unsigned int state = 12345;
+    for (int i = 0; i < count; ++i) {
+        state = state * 1664525u + 1013904223u;
+        float range = (i % 3 == 0) ? 64.0f : (i % 3 == 1) ? 4096.0f : 1000000.0f;
+        x[i] = (static_cast<int>(state >> 8) % 2001 - 1000) / 1000.0f * range;
+        y[i] = (static_cast<int>(state >> 3) % 2001 - 1000) / 1000.0f * range;
+        z[i] = (static_cast<int>(state >> 13) % 2001 - 1000) / 1000.0f * range;
+        if (i % 5 == 0) {
+            x[i] = static_cast<float>(static_cast<int>(x[i]));
+            y[i] = static_cast<float>(static_cast<int>(y[i]));
+            z[i] = static_cast<float>(static_cast<int>(z[i]));
+        }
+    }
+
+    getNoise(x.data(), y.data(), simdOut.data(), count);
+    for (int i = 0; i < count; ++i) {
+        scalarOut[i] = noise.GetNoise(x[i], y[i]);
+    }
+    bool matches = std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(float)) == 0;
+
+    // OpenSimplex2 has a 3D kernel too
+    if (matches && type == FastNoiseLite::NoiseType_OpenSimplex2) {
+        getNoise(x.data(), y.data(), z.data(), simdOut.data(), count);
+        for (int i = 0; i < count; ++i) {
+            scalarOut[i] = noise.GetNoise(x[i], y[i], z[i]);
+        }
+        matches = std::memcmp(simdOut.data(), scalarOut.data(), count * sizeof(float)) == 0;
+    }
+
+    if (!matches) {
+        std::cerr << getNoiseSimdName(simd) << " noise kernels don't match FastNoiseLite, using scalar noise" << std::endl;
+        simd = NoiseSimd::Scalar;
+        return false;
+    }
+    return true;
+}
+
+ChunkNoises noiseInit(int seed, NoiseSimd simd) {
     ChunkNoises noises;
 
-    int seed = getOptionInt("world_seed", 1234);
+    noises.biomeNoise.setNoiseType(FastNoiseLite::NoiseType_Cellular);
+    noises.biomeNoise.setCellularReturnType(FastNoiseLite::CellularReturnType_CellValue);
+    noises.biomeNoise.setCellularDistanceFunction(FastNoiseLite::CellularDistanceFunction_Hybrid);
+    noises.biomeNoise.setFrequency(0.0025f);
+    noises.biomeNoise.setSeed(seed + 10);
 
-    noises.biomeNoise.SetNoiseType(FastNoiseLite::NoiseType_Cellular);
-    noises.biomeNoise.SetCellularReturnType(FastNoiseLite::CellularReturnType_CellValue);
-    noises.biomeNoise.SetCellularDistanceFunction(FastNoiseLite::CellularDistanceFunction_Hybrid);
-    noises.biomeNoise.SetFrequency(0.0025f);
-    noises.biomeNoise.SetSeed(seed + 10);
+    noises.biomeDistortNoise.setNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    noises.biomeDistortNoise.setFrequency(0.03f);
+    noises.biomeDistortNoise.setSeed(seed + 11);
 
-    noises.biomeDistortNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    noises.biomeDistortNoise.SetFrequency(0.03f);
-    noises.biomeDistortNoise.SetSeed(seed + 11);
+    noises.baseNoise.setNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    noises.baseNoise.setFrequency(0.005f);
+    noises.baseNoise.setSeed(seed);
 
-    noises.baseNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    noises.baseNoise.SetFrequency(0.005f);
-    noises.baseNoise.SetSeed(seed);
+    noises.detailNoise.setNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    noises.detailNoise.setFrequency(0.02f);
+    noises.detailNoise.setSeed(seed + 1);
 
-    noises.detailNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    noises.detailNoise.SetFrequency(0.02f);
-    noises.detailNoise.SetSeed(seed + 1);
+    noises.detail2Noise.setNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    noises.detail2Noise.setFrequency(0.05f);
+    noises.detail2Noise.setSeed(seed + 2);
 
-    noises.detail2Noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    noises.detail2Noise.SetFrequency(0.05f);
-    noises.detail2Noise.SetSeed(seed + 2);
+    noises.caveNoise.setNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    noises.caveNoise.setFrequency(0.03f);
+    noises.caveNoise.setSeed(seed + 4);
 
-    noises.featureNoise.SetNoiseType(FastNoiseLite::NoiseType_Value);
-    noises.featureNoise.SetFrequency(500.0f);
-    noises.featureNoise.SetSeed(seed + 3);
+    // Terrain has to come out the same whichever kernels run, check them once per world
+    noises.biomeNoise.useSimd(simd);
+    noises.biomeDistortNoise.useSimd(simd);
+    noises.baseNoise.useSimd(simd);
+    noises.detailNoise.useSimd(simd);
+    noises.detail2Noise.useSimd(simd);
+    noises.caveNoise.useSimd(simd);
 
     return noises;
 }
@@ -1,14 +1,63 @@
 #pragma once
 
 #include <FastNoiseLite.h>
+#include "noiseKernels.hpp"
+
+// FastNoiseLite with the same settings exposed, plus a batched getNoise that evaluates many
+// points at once. Batches of OpenSimplex2 (2D and 3D) and 2D cellular noise run on the SIMD
+// kernels in noiseKernels.cpp, everything else (and Scalar) loops over FastNoiseLite.
+class BatchNoise {
+public:
+    void setSeed(int seed);
+    void setFrequency(float frequency);
+    void setNoiseType(FastNoiseLite::NoiseType type);
+    void setCellularDistanceFunction(FastNoiseLite::CellularDistanceFunction distanceFunction);
+    void setCellularReturnType(FastNoiseLite::CellularReturnType returnType);
+
+    float getNoise(float x, float y) const { return noise.GetNoise(x, y); }
+    // out[i] = getNoise(x[i], y[i]) for every i < count
+    void getNoise(const float* x, const float* y, float* out, int count) const;
+
+    float getNoise(float x, float y, float z) const { return noise.GetNoise(x, y, z); }
+    // out[i] = getNoise(x[i], y[i], z[i]) for every i < count
+    void getNoise(const float* x, const float* y, const float* z, float* out, int count) const;
+
+    // Switches batches to the given kernels and compares them against FastNoiseLite on a fixed
+    // set of points. Falls back to Scalar and returns false if any result isn't bit identical.
+    bool useSimd(NoiseSimd level);
+    NoiseSimd getSimd() const { return simd; }
+
+private:
+    FastNoiseLite noise;
+    FastNoiseLite::NoiseType type = FastNoiseLite::NoiseType_OpenSimplex2;
+    NoiseKernelParams params;
+    NoiseSimd simd = NoiseSimd::Scalar;
+};
 
 struct ChunkNoises {
-    FastNoiseLite biomeNoise;
-    FastNoiseLite baseNoise;
-    FastNoiseLite detailNoise;
-    FastNoiseLite detail2Noise;
-    FastNoiseLite featureNoise;
-    FastNoiseLite biomeDistortNoise;
+    BatchNoise biomeNoise;
+    BatchNoise baseNoise;
+    BatchNoise detailNoise;
+    BatchNoise detail2Noise;
+    BatchNoise biomeDistortNoise;
+    BatchNoise caveNoise; // 3D
 };
 
-ChunkNoises noiseInit();
+ChunkNoises noiseInit(int seed, NoiseSimd simd);
+
+// Everything terrain generation derives from the seed. Built once per world and only
+// read afterwards (every getNoise overload is const), so generation jobs share it.
+struct GeneratorContext {
+    // Columns per side of the blocks sharing one biome sample in coarse mode
+    static const int BIOME_BLOCK = 4;
+
+    const int seed;
+    const ChunkNoises noises;
+    // Biome noise sampled once per 4x4 columns instead of per column, changes the biome borders
+    const bool coarseBiomes;
+    // 3D cave carving (CaveDensity)
+    const bool caves;
+
+    GeneratorContext(int seed, NoiseSimd simd, bool coarseBiomes, bool caves)
+        : seed(seed), noises(noiseInit(seed, simd)), coarseBiomes(coarseBiomes), caves(caves) {}
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <FastNoiseLite.h>
+
+// Instruction sets the batched noise kernels can run on
+enum class NoiseSimd {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Best instruction set supported by this CPU (and OS), Scalar on non x86 builds
+NoiseSimd detectNoiseSimd();
+const char* getNoiseSimdName(NoiseSimd simd);
+
+// The FastNoiseLite settings the kernels need, FastNoiseLite keeps its own private
+struct NoiseKernelParams {
+    int seed = 1337;
+    float frequency = 0.01f;
+    FastNoiseLite::CellularDistanceFunction distanceFunction = FastNoiseLite::CellularDistanceFunction_EuclideanSq;
+    FastNoiseLite::CellularReturnType returnType = FastNoiseLite::CellularReturnType_Distance;
+    float jitter = 1.0f;
+};
+
+// 2D OpenSimplex2 and cellular noise for count points, out[i] is the noise at (x[i], y[i]),
+// and 3D OpenSimplex2 at (x[i], y[i], z[i]) with FastNoiseLite's default 3D rotation.
+// Ports of FastNoiseLite's SingleSimplex, SingleOpenSimplex2 and SingleCellular doing the same
+// float operations in the same order, so results are bit identical to FastNoiseLite::GetNoise.
+// simd must not be Scalar, callers handle that case with FastNoiseLite directly.
+void simplexNoiseBatch(NoiseSimd simd, const NoiseKernelParams& params, const float* x, const float* y, float* out, int count);
+void simplexNoiseBatch(NoiseSimd simd, const NoiseKernelParams& params, const float* x, const float* y, const float* z, float* out, int count);
+void cellularNoiseBatch(NoiseSimd simd, const NoiseKernelParams& params, const float* x, const float* y, float* out, int count);
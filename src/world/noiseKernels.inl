@@ -0,0 +1,308 @@
+// Kernel bodies shared by every instruction set, included by noiseKernels.cpp inside a
+// namespace that defines F (float vector), I (int vector), LANES, NOISE_TARGET and the
+// vector helpers. Keep the float operations in the same order as FastNoiseLite.h.
+
+NOISE_TARGET static inline F loadLanes(const float* src, int lanes) {
+    if (lanes == LANES) return loadF(src);
+    alignas(32) float tmp[LANES] = {};
+    for (int i = 0; i < lanes; ++i) tmp[i] = src[i];
+    return loadF(tmp);
+}
+
+NOISE_TARGET static inline void storeLanes(float* dst, F v, int lanes) {
+    if (lanes == LANES) {
+        storeF(dst, v);
+        return;
+    }
+    alignas(32) float tmp[LANES];
+    storeF(tmp, v);
+    for (int i = 0; i < lanes; ++i) dst[i] = tmp[i];
+}
+
+// (int)f - 1 for negative f, even for whole numbers, like FastFloor
+NOISE_TARGET static inline I fastFloor(F f) {
+    return addI(truncate(f), asInt(lessThan(f, set1F(0.0f))));
+}
+
+NOISE_TARGET static inline I fastRound(F f) {
+    F half = set1F(0.5f);
+    return truncate(selectF(lessThan(f, set1F(0.0f)), sub(f, half), add(f, half)));
+}
+
+NOISE_TARGET static inline I hashCoord(I seed, I xPrimed, I yPrimed) {
+    return mulI(xorI(xorI(seed, xPrimed), yPrimed), set1I(0x27d4eb2d));
+}
+
+NOISE_TARGET static inline F gradCoord(I seed, I xPrimed, I yPrimed, F xd, F yd) {
+    I hash = hashCoord(seed, xPrimed, yPrimed);
+    hash = xorI(hash, sraI(hash, 15));
+    hash = andI(hash, set1I(127 << 1));
+
+    F xg = gather(GRADIENTS_2D, hash);
+    F yg = gather(GRADIENTS_2D, orI(hash, set1I(1)));
+    return add(mul(xd, xg), mul(yd, yg));
+}
+
+NOISE_TARGET static inline I hashCoord(I seed, I xPrimed, I yPrimed, I zPrimed) {
+    return mulI(xorI(xorI(xorI(seed, xPrimed), yPrimed), zPrimed), set1I(0x27d4eb2d));
+}
+
+NOISE_TARGET static inline F gradCoord(I seed, I xPrimed, I yPrimed, I zPrimed, F xd, F yd, F zd) {
+    I hash = hashCoord(seed, xPrimed, yPrimed, zPrimed);
+    hash = xorI(hash, sraI(hash, 15));
+    hash = andI(hash, set1I(63 << 2));
+
+    F xg = gather(GRADIENTS_3D, hash);
+    F yg = gather(GRADIENTS_3D, orI(hash, set1I(1)));
+    F zg = gather(GRADIENTS_3D, orI(hash, set1I(2)));
+    return add(add(mul(xd, xg), mul(yd, yg)), mul(zd, zg));
+}
+
+// (a * a) * (a * a) * gradient where a > 0, zero elsewhere
+NOISE_TARGET static inline F falloff(F a, F gradient) {
+    F a2 = mul(a, a);
+    return andF(greaterThan(a, set1F(0.0f)), mul(mul(a2, a2), gradient));
+}
+
+NOISE_TARGET static void simplexBatch(const NoiseKernelParams& params, const float* xs, const float* ys, float* out, int count) {
+    const float SQRT3 = (float)1.7320508075688772935274463415059;
+    const float F2 = 0.5f * (SQRT3 - 1);
+    const float G2 = (3 - SQRT3) / 6;
+
+    const I seed = set1I(params.seed);
+    const I primeX = set1I(PRIME_X);
+    const I primeY = set1I(PRIME_Y);
+    const F frequency = set1F(params.frequency);
+
+    for (int n = 0; n < count; n += LANES) {
+        int lanes = (count - n < LANES) ? count - n : LANES;
+        F x = mul(loadLanes(xs + n, lanes), frequency);
+        F y = mul(loadLanes(ys + n, lanes), frequency);
+
+        // Skew, TransformNoiseCoordinate in FastNoiseLite
+        F s = mul(add(x, y), set1F(F2));
+        x = add(x, s);
+        y = add(y, s);
+
+        I i = fastFloor(x);
+        I j = fastFloor(y);
+        F xi = sub(x, toFloat(i));
+        F yi = sub(y, toFloat(j));
+
+        F t = mul(add(xi, yi), set1F(G2));
+        F x0 = sub(xi, t);
+        F y0 = sub(yi, t);
+
+        i = mulI(i, primeX);
+        j = mulI(j, primeY);
+
+        F a = sub(sub(set1F(0.5f), mul(x0, x0)), mul(y0, y0));
+        F n0 = falloff(a, gradCoord(seed, i, j, x0, y0));
+
+        F c = add(mul(set1F((float)(2 * (1 - 2 * G2) * (1 / G2 - 2))), t),
+                  add(set1F((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2))), a));
+        F x2 = add(x0, set1F(2 * (float)G2 - 1));
+        F y2 = add(y0, set1F(2 * (float)G2 - 1));
+        F n2 = falloff(c, gradCoord(seed, addI(i, primeX), addI(j, primeY), x2, y2));
+
+        // Middle corner depends on which triangle of the cell we're in
+        F upper = greaterThan(y0, x0);
+        F x1 = add(x0, selectF(upper, set1F((float)G2), set1F((float)G2 - 1)));
+        F y1 = add(y0, selectF(upper, set1F((float)G2 - 1), set1F((float)G2)));
+        I i1 = addI(i, andNotI(asInt(upper), primeX));
+        I j1 = addI(j, andI(asInt(upper), primeY));
+        F b = sub(sub(set1F(0.5f), mul(x1, x1)), mul(y1, y1));
+        F n1 = falloff(b, gradCoord(seed, i1, j1, x1, y1));
+
+        storeLanes(out + n, mul(add(add(n0, n1), n2), set1F(99.83685446303647f)), lanes);
+    }
+}
+
+NOISE_TARGET static void simplexBatch(const NoiseKernelParams& params, const float* xs, const float* ys, const float* zs, float* out, int count) {
+    const float R3 = (float)(2.0 / 3.0);
+    const I primeX = set1I(PRIME_X);
+    const I primeY = set1I(PRIME_Y);
+    const I primeZ = set1I(PRIME_Z);
+    const F frequency = set1F(params.frequency);
+    const I zeroI = set1I(0);
+
+    for (int n = 0; n < count; n += LANES) {
+        int lanes = (count - n < LANES) ? count - n : LANES;
+        F x = mul(loadLanes(xs + n, lanes), frequency);
+        F y = mul(loadLanes(ys + n, lanes), frequency);
+        F z = mul(loadLanes(zs + n, lanes), frequency);
+
+        // Rotation, TransformNoiseCoordinate in FastNoiseLite
+        F r = mul(add(add(x, y), z), set1F(R3));
+        x = sub(r, x);
+        y = sub(r, y);
+        z = sub(r, z);
+
+        I i = fastRound(x);
+        I j = fastRound(y);
+        I k = fastRound(z);
+        F x0 = sub(x, toFloat(i));
+        F y0 = sub(y, toFloat(j));
+        F z0 = sub(z, toFloat(k));
+
+        // -1 or 1, the direction of the far corner along each axis
+        I xNSign = orI(truncate(sub(set1F(-1.0f), x0)), set1I(1));
+        I yNSign = orI(truncate(sub(set1F(-1.0f), y0)), set1I(1));
+        I zNSign = orI(truncate(sub(set1F(-1.0f), z0)), set1I(1));
+
+        F ax0 = mul(toFloat(xNSign), negF(x0));
+        F ay0 = mul(toFloat(yNSign), negF(y0));
+        F az0 = mul(toFloat(zNSign), negF(z0));
+
+        i = mulI(i, primeX);
+        j = mulI(j, primeY);
+        k = mulI(k, primeZ);
+
+        I seed = set1I(params.seed);
+        F value = set1F(0.0f);
+        F a = sub(sub(set1F(0.6f), mul(x0, x0)), add(mul(y0, y0), mul(z0, z0)));
+
+        // Both offset grids, the second one with the inverted seed
+        for (int l = 0; ; l++) {
+            value = add(value, falloff(a, gradCoord(seed, i, j, k, x0, y0, z0)));
+
+            // Step to the neighbouring corner along the axis the point is furthest along
+            F alongX = andF(greaterEqual(ax0, ay0), greaterEqual(ax0, az0));
+            F alongY = andNotF(alongX, andF(greaterThan(ay0, ax0), greaterEqual(ay0, az0)));
+            F alongZ = andNotF(alongX, andNotF(alongY, asFloat(set1I(-1))));
+
+            F x1 = selectF(alongX, add(x0, toFloat(xNSign)), x0);
+            F y1 = selectF(alongY, add(y0, toFloat(yNSign)), y0);
+            F z1 = selectF(alongZ, add(z0, toFloat(zNSign)), z0);
+            F b = add(a, set1F(1.0f));
+            b = selectF(alongX, sub(b, mul(toFloat(addI(xNSign, xNSign)), x1)),
+                selectF(alongY, sub(b, mul(toFloat(addI(yNSign, yNSign)), y1)),
+                                sub(b, mul(toFloat(addI(zNSign, zNSign)), z1))));
+            I i1 = subI(i, andI(asInt(alongX), mulI(xNSign, primeX)));
+            I j1 = subI(j, andI(asInt(alongY), mulI(yNSign, primeY)));
+            I k1 = subI(k, andI(asInt(alongZ), mulI(zNSign, primeZ)));
+
+            value = add(value, falloff(b, gradCoord(seed, i1, j1, k1, x1, y1, z1)));
+
+            if (l == 1) break;
+
+            ax0 = sub(set1F(0.5f), ax0);
+            ay0 = sub(set1F(0.5f), ay0);
+            az0 = sub(set1F(0.5f), az0);
+
+            x0 = mul(toFloat(xNSign), ax0);
+            y0 = mul(toFloat(yNSign), ay0);
+            z0 = mul(toFloat(zNSign), az0);
+
+            a = add(a, sub(sub(set1F(0.75f), ax0), add(ay0, az0)));
+
+            i = addI(i, andI(sraI(xNSign, 1), primeX));
+            j = addI(j, andI(sraI(yNSign, 1), primeY));
+            k = addI(k, andI(sraI(zNSign, 1), primeZ));
+
+            xNSign = subI(zeroI, xNSign);
+            yNSign = subI(zeroI, yNSign);
+            zNSign = subI(zeroI, zNSign);
+
+            seed = xorI(seed, set1I(-1));
+        }
+
+        storeLanes(out + n, mul(value, set1F(32.69428253173828125f)), lanes);
+    }
+}
+
+NOISE_TARGET static void cellularBatch(const NoiseKernelParams& params, const float* xs, const float* ys, float* out, int count) {
+    const I seed = set1I(params.seed);
+    const F frequency = set1F(params.frequency);
+    const F jitter = set1F(0.43701595f * params.jitter);
+
+    for (int n = 0; n < count; n += LANES) {
+        int lanes = (count - n < LANES) ? count - n : LANES;
+        F x = mul(loadLanes(xs + n, lanes), frequency);
+        F y = mul(loadLanes(ys + n, lanes), frequency);
+
+        I xr = fastRound(x);
+        I yr = fastRound(y);
+
+        F distance0 = set1F(1e10f);
+        F distance1 = set1F(1e10f);
+        I closestHash = set1I(0);
+
+        I xPrimed = mulI(subI(xr, set1I(1)), set1I(PRIME_X));
+        I yPrimedBase = mulI(subI(yr, set1I(1)), set1I(PRIME_Y));
+
+        for (int xOffset = -1; xOffset <= 1; ++xOffset) {
+            I yPrimed = yPrimedBase;
+            F cellX = sub(toFloat(addI(xr, set1I(xOffset))), x);
+
+            for (int yOffset = -1; yOffset <= 1; ++yOffset) {
+                I hash = hashCoord(seed, xPrimed, yPrimed);
+                I idx = andI(hash, set1I(255 << 1));
+
+                F vecX = add(cellX, mul(gather(RAND_VECS_2D, idx), jitter));
+                F vecY = add(sub(toFloat(addI(yr, set1I(yOffset))), y), mul(gather(RAND_VECS_2D, orI(idx, set1I(1))), jitter));
+
+                F newDistance;
+                switch (params.distanceFunction) {
+                    default:
+                    case FastNoiseLite::CellularDistanceFunction_Euclidean:
+                    case FastNoiseLite::CellularDistanceFunction_EuclideanSq:
+                        newDistance = add(mul(vecX, vecX), mul(vecY, vecY));
+                        break;
+                    case FastNoiseLite::CellularDistanceFunction_Manhattan:
+                        newDistance = add(absF(vecX), absF(vecY));
+                        break;
+                    case FastNoiseLite::CellularDistanceFunction_Hybrid:
+                        newDistance = add(add(absF(vecX), absF(vecY)), add(mul(vecX, vecX), mul(vecY, vecY)));
+                        break;
+                }
+
+                distance1 = maxF(minF(distance1, newDistance), distance0);
+                F closer = lessThan(newDistance, distance0);
+                distance0 = selectF(closer, newDistance, distance0);
+                closestHash = selectI(asInt(closer), hash, closestHash);
+
+                yPrimed = addI(yPrimed, set1I(PRIME_Y));
+            }
+            xPrimed = addI(xPrimed, set1I(PRIME_X));
+        }
+
+        if (params.distanceFunction == FastNoiseLite::CellularDistanceFunction_Euclidean &&
+            params.returnType >= FastNoiseLite::CellularReturnType_Distance) {
+            distance0 = sqrtF(distance0);
+            if (params.returnType >= FastNoiseLite::CellularReturnType_Distance2) {
+                distance1 = sqrtF(distance1);
+            }
+        }
+
+        const F one = set1F(1.0f);
+        F result;
+        switch (params.returnType) {
+            case FastNoiseLite::CellularReturnType_CellValue:
+                result = mul(toFloat(closestHash), set1F(1 / 2147483648.0f));
+                break;
+            case FastNoiseLite::CellularReturnType_Distance:
+                result = sub(distance0, one);
+                break;
+            case FastNoiseLite::CellularReturnType_Distance2:
+                result = sub(distance1, one);
+                break;
+            case FastNoiseLite::CellularReturnType_Distance2Add:
+                result = sub(mul(add(distance1, distance0), set1F(0.5f)), one);
+                break;
+            case FastNoiseLite::CellularReturnType_Distance2Sub:
+                result = sub(sub(distance1, distance0), one);
+                break;
+            case FastNoiseLite::CellularReturnType_Distance2Mul:
+                result = sub(mul(mul(distance1, distance0), set1F(0.5f)), one);
+                break;
+            case FastNoiseLite::CellularReturnType_Distance2Div:
+                result = sub(div(distance0, distance1), one);
+                break;
+            default:
+                result = set1F(0.0f);
+                break;
+        }
+        storeLanes(out + n, result, lanes);
+    }
+}
@@ -1,6 +1,55 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
 #include "structureDB.hpp"
 
-std::unordered_map<std::string, Structure> StructureDB::structures;
+std::vector<Structure> StructureDB::structures;
+std::unordered_map<std::string, int> StructureDB::ids;
+
+Structure::Structure(const std::string& name, const std::vector<StructureLayer>& layers)
+    : name(name), layers(layers) {
+    for (int y = 0; y < (int)layers.size(); ++y) {
+        for (int z = 0; z < (int)layers[y].size(); ++z) {
+            const std::vector<uint8_t>& row = layers[y][z];
+            for (int x = 0; x < (int)row.size();) {
+                uint8_t type = row[x];
+                int length = 1;
+                while (x + length < (int)row.size() && row[x + length] == type) ++length;
+
+                if (type != 0) {
+                    if (runs.empty()) {
+                        minX = maxX = x;
+                        minY = maxY = y;
+                        minZ = maxZ = z;
+                    }
+                    runs.push_back({x, y, z, length, type});
+                    minX = std::min(minX, x);
+                    maxX = std::max(maxX, x + length - 1);
+                    minY = std::min(minY, y);
+                    maxY = std::max(maxY, y);
+                    minZ = std::min(minZ, z);
+                    maxZ = std::max(maxZ, z);
+                }
+                x += length;
+            }
+        }
+    }
+}
+
+void StructureDB::add(const std::string& name, const std::vector<StructureLayer>& layers) {
+    ids[name] = (int)structures.size();
+    structures.emplace_back(name, layers);
+
+    // Checked in every build, placeChunkFeatures would silently clip a larger structure
+    const Structure& structure = structures.back();
+    int width = structure.maxX - structure.minX + 1;
+    int depth = structure.maxZ - structure.minZ + 1;
+    if (width > Structure::MAX_SIZE || depth > Structure::MAX_SIZE) {
+        std::cerr << "Structure " << name << " is " << width << "x" << depth << " blocks, at most "
+                  << Structure::MAX_SIZE << "x" << Structure::MAX_SIZE << " fit next to their anchor chunk" << std::endl;
+        std::abort();
+    }
+}
 
 void StructureDB::initialize() {
     std::vector<StructureLayer> treeLayers = {
@@ -56,19 +105,19 @@ void StructureDB::initialize() {
 
 
     };
-    structures["tree"] = Structure("tree", treeLayers);
+    add("tree", treeLayers);
 
     std::vector<StructureLayer> cactusLayers = {
         { {12} },
         { {12} },
         { {12} }
     };
-    structures["cactus"] = Structure("cactus", cactusLayers);
+    add("cactus", cactusLayers);
 }
 
-const Structure* StructureDB::get(const std::string& name) {
-    auto it = structures.find(name);
-    if (it != structures.end())
-        return &it->second;
-    return nullptr;
+int StructureDB::getID(const std::string& name) {
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+    return -1;
 }
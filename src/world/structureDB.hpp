@@ -9,19 +9,40 @@ using StructureLayer = std::vector<std::vector<uint8_t>>;
 
 class Structure {
 public:
+    // Row of one block type from (x, y, z) to (x + length - 1, y, z)
+    struct Run {
+        int x, y, z;
+        int length;
+        uint8_t type;
+    };
+
     std::string name;
-    std::vector<StructureLayer> layers;
+    std::vector<StructureLayer> layers; // layers[y][z][x], 0 is air
+
+    // Largest footprint along x and z. Features are stamped by the chunks next to the anchor's
+    // chunk only, so a structure reaching further than that would be clipped.
+    static const int MAX_SIZE = 16;
+
+    // Compiled from layers: the non-air cells as runs sorted by y then z, and their bounding box
+    std::vector<Run> runs;
+    int minX = 0, minY = 0, minZ = 0;
+    int maxX = -1, maxY = -1, maxZ = -1;
 
     Structure() = default;
-    Structure(const std::string& name, const std::vector<StructureLayer>& layers)
-        : name(name), layers(layers) {}
+    Structure(const std::string& name, const std::vector<StructureLayer>& layers);
 };
 
+// Structures are registered by name and referenced by their ID (index) afterwards
 class StructureDB {
 public:
     static void initialize();
-    static const Structure* get(const std::string& name);
+    // -1 if there is no structure with that name
+    static int getID(const std::string& name);
+    static const Structure& get(int id) { return structures[id]; }
 
 private:
-    static std::unordered_map<std::string, Structure> structures;
+    static std::vector<Structure> structures;
+    static std::unordered_map<std::string, int> ids;
+
+    static void add(const std::string& name, const std::vector<StructureLayer>& layers);
 };
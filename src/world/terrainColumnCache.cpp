@@ -0,0 +1,116 @@
+#include <algorithm>
+#include "terrainColumnCache.hpp"
+#include "chunkTerrain.hpp"
+
+static int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+TerrainColumnCache::TerrainColumnCache(const GeneratorContext& generator, int maxRegions)
+    : generator(generator), maxRegions(maxRegions) {}
+
+void TerrainColumnCache::getColumns(int x, int z, int width, int depth, Chunk::Biome* biomes, float* heights) {
+    int firstTileX = floorDiv(x, Chunk::WIDTH);
+    int firstTileZ = floorDiv(z, Chunk::DEPTH);
+    int lastTileX = floorDiv(x + width - 1, Chunk::WIDTH);
+    int lastTileZ = floorDiv(z + depth - 1, Chunk::DEPTH);
+
+    for (int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+        for (int tileZ = firstTileZ; tileZ <= lastTileZ; ++tileZ) {
+            std::shared_ptr<const Tile> tile = getTile(tileX, tileZ);
+
+            // Overlap of the tile and the requested window
+            int startX = std::max(x, tileX * Chunk::WIDTH);
+            int endX = std::min(x + width, (tileX + 1) * Chunk::WIDTH);
+            int startZ = std::max(z, tileZ * Chunk::DEPTH);
+            int endZ = std::min(z + depth, (tileZ + 1) * Chunk::DEPTH);
+
+            for (int wx = startX; wx < endX; ++wx) {
+                for (int wz = startZ; wz < endZ; ++wz) {
+                    int src = (wx - tileX * Chunk::WIDTH) * Chunk::DEPTH + (wz - tileZ * Chunk::DEPTH);
+                    int dst = (wx - x) * depth + (wz - z);
+                    biomes[dst] = tile->biomes[src];
+                    heights[dst] = tile->heights[src];
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<const TerrainColumnCache::Tile> TerrainColumnCache::getTile(int tileX, int tileZ) {
+    int regionX = floorDiv(tileX, REGION_SIZE);
+    int regionZ = floorDiv(tileZ, REGION_SIZE);
+    int index = (tileX - regionX * REGION_SIZE) * REGION_SIZE + (tileZ - regionZ * REGION_SIZE);
+
+    std::shared_ptr<Region> region = useRegion(regionX, regionZ);
+    {
+        std::shared_lock<std::shared_mutex> lock(region->mutex);
+        if (region->tiles[index]) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return region->tiles[index];
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Computed outside the lock. Two jobs may race for the same tile, they compute the same values.
+    std::shared_ptr<Tile> tile = std::make_shared<Tile>();
+    generateTerrainColumns(generator, tileX, tileZ, tile->biomes, tile->heights);
+
+    std::unique_lock<std::shared_mutex> lock(region->mutex);
+    std::shared_ptr<const Tile>& slot = region->tiles[index];
+    if (!slot) {
+        slot = tile;
+        if (!region->evicted) tileCount++;
+    }
+    return slot;
+}
+
+std::shared_ptr<TerrainColumnCache::Region> TerrainColumnCache::useRegion(int regionX, int regionZ) {
+    std::pair<int, int> key = {regionX, regionZ};
+    {
+        std::shared_lock<std::shared_mutex> lock(regionsMutex);
+        auto it = regions.find(key);
+        if (it != regions.end()) {
+            it->second->lastUse.store(useClock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(regionsMutex);
+    // Another job may have added it since the lookup
+    auto it = regions.find(key);
+    if (it != regions.end()) {
+        it->second->lastUse.store(useClock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return it->second;
+    }
+
+    // Make room first so the new region isn't the one evicted
+    while (!regions.empty() && static_cast<int>(regions.size()) >= maxRegions) {
+        auto oldest = std::min_element(regions.begin(), regions.end(), [](const auto& a, const auto& b) {
+            return a.second->lastUse.load(std::memory_order_relaxed) < b.second->lastUse.load(std::memory_order_relaxed);
+        });
+        Region& evicted = *oldest->second;
+        std::unique_lock<std::shared_mutex> regionLock(evicted.mutex);
+        for (const std::shared_ptr<const Tile>& tile : evicted.tiles) {
+            if (tile) tileCount--;
+        }
+        evicted.evicted = true;
+        regionLock.unlock();
+        regions.erase(oldest);
+    }
+
+    std::shared_ptr<Region> region = std::make_shared<Region>();
+    region->lastUse.store(useClock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    regions.emplace(key, region);
+    return region;
+}
+
+int TerrainColumnCache::getTileCount() const {
+    return tileCount.load(std::memory_order_relaxed);
+}
+
+float TerrainColumnCache::getHitRate() const {
+    uint64_t hitCount = hits.load(std::memory_order_relaxed);
+    uint64_t total = hitCount + misses.load(std::memory_order_relaxed);
+    return total ? static_cast<float>(hitCount) / total : 0.0f;
+}
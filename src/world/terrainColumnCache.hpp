@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include "chunk.hpp"
+#include "noise.hpp"
+
+// Biome and pre-blend surface height of every world column, shared by the generation jobs so
+// the blend border a chunk needs is only computed once for all its neighbours. Columns are
+// computed a chunk sized tile at a time on first use, tiles are grouped in regions of
+// REGION_SIZE x REGION_SIZE chunks and whole regions are evicted least recently used first.
+// The values only depend on the seed, so eviction never changes the terrain.
+//
+// Lookups only share locks: the region table and each region have a reader-writer lock, taken
+// exclusively only to add a region or tile. Jobs reading cached tiles never wait on each other.
+class TerrainColumnCache {
+public:
+    static const int REGION_SIZE = 32; // In chunks
+
+    struct Tile {
+        Chunk::Biome biomes[Chunk::WIDTH * Chunk::DEPTH]; // [x * DEPTH + z]
+        float heights[Chunk::WIDTH * Chunk::DEPTH];
+    };
+
+    TerrainColumnCache(const GeneratorContext& generator, int maxRegions);
+
+    // Copies the columns [x, x + width) x [z, z + depth) in world coordinates, indexed [dx * depth + dz].
+    // Thread safe.
+    void getColumns(int x, int z, int width, int depth, Chunk::Biome* biomes, float* heights);
+
+    int getTileCount() const;
+    float getHitRate() const;
+
+private:
+    struct Region {
+        std::shared_mutex mutex; // Guards tiles and evicted
+        std::shared_ptr<const Tile> tiles[REGION_SIZE * REGION_SIZE];
+        bool evicted = false; // Tiles added afterwards aren't counted
+        std::atomic<uint64_t> lastUse{0}; // useClock at the last lookup
+    };
+
+    const GeneratorContext& generator;
+    const int maxRegions;
+
+    mutable std::shared_mutex regionsMutex; // Guards regions
+    std::map<std::pair<int, int>, std::shared_ptr<Region>> regions;
+    // Advances when a region is added, lookups stamp their region with it. The region with the
+    // oldest stamp is evicted, so regions are least recently used as of the last addition.
+    std::atomic<uint64_t> useClock{0};
+    std::atomic<int> tileCount{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    // Shared so an evicted tile stays valid for the job still copying from it
+    std::shared_ptr<const Tile> getTile(int tileX, int tileZ);
+    // Shared for the same reason, a job may still add a tile to an evicted region
+    std::shared_ptr<Region> useRegion(int regionX, int regionZ);
+};
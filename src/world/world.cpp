@@ -3,32 +3,84 @@
 #include <cmath>
 #include <deque>
 #include <algorithm>
+#include <chrono>
 #include "world.hpp"
+#include "chunkMesher.hpp"
+#include "../core/options.hpp"
 
 static std::deque<std::pair<int, int>> chunkLoadQueue;
 
-World::World() {}
+struct World::MeshJob {
+    SectionSnapshot snapshot;
+    SectionMeshData mesh;
+    Chunk::MeshingMode mode;
+    uint64_t revision;
+    MeshJob* next = nullptr; // meshedChunks link
+};
+
+struct World::SortJob {
+    int chunkX, chunkZ, sectionY;
+    uint64_t revision;   // Uploaded mesh the centres belong to
+    glm::vec3 cameraPos;
+    glm::vec3 eye;       // Camera relative to the section origin
+    std::vector<PackedVertex> vertices;
+    std::vector<uint64_t> keys;
+    std::vector<PackedVertex> sorted;
+    float sortMs = 0.0f;
+    SortJob* next = nullptr; // sortedSections link
+};
+
+// The order of far sections changes slower: they're re-sorted once the camera moved this
+// fraction of its distance to them (and always entered another block)
+static const float SORT_DISTANCE_FRACTION = 1.0f / 8.0f;
+
+static glm::vec3 getSectionCenter(const Chunk* chunk, int sectionY) {
+    return glm::vec3(chunk->chunkX * Chunk::WIDTH, sectionY * ChunkSection::SIZE, chunk->chunkZ * Chunk::DEPTH) +
+           glm::vec3(ChunkSection::SIZE * 0.5f);
+}
+
+World::World()
+    : chunks(getOptionInt("render_distance", 7) + 1) // Same radius as Renderer, +1 for the mesh helper ring
+    , generator(getOptionInt("world_seed", 1234), getOptionInt("simd_noise", 1) ? detectNoiseSimd() : NoiseSimd::Scalar,
+                getOptionInt("coarse_biomes", 0) != 0, getOptionInt("caves", 0) != 0)
+    , columnCache(generator, 16) // 4x4 regions of 32x32 chunks, enough for the largest render distance
+    , vertexArena(1 << 20) // 8 MiB, grows when the render distance needs more
+{
+    Chunk::meshingMode = getOptionInt("greedy_meshing", 1) ? Chunk::MeshingMode::Greedy : Chunk::MeshingMode::PerFace;
+}
 
 World::~World() {
-    for (auto& [coord, chunk] : chunks) {
+    // Stop generation before tearing down, workers push into generatedChunks
+    jobs.shutdown();
+    std::vector<Chunk*> leftovers;
+    generatedChunks.popAll(leftovers);
+    for (Chunk* chunk : leftovers) {
         delete chunk;
     }
-    chunks.clear();
+
+    for (const auto& slot : chunks.getSlots()) {
+        delete slot.chunk;
+    }
 }
 
 void World::generateChunks(int radius) {
+    if (radius > chunks.getRadius()) {
+        std::vector<Chunk*> evicted;
+        chunks.resize(radius, evicted);
+    }
+
     // Create chunks
+    std::set<Chunk*> dirtyChunks;
     for (int x = -radius; x <= radius; ++x) {
         for (int z = -radius; z <= radius; ++z) {
-            std::pair<int, int> pos = {x, z};
-            if (chunks.find(pos) == chunks.end()) {
-                chunks[pos] = new Chunk(x, z, this);
+            if (!getChunk(x, z)) {
+                integrateChunk(new Chunk(x, z, this), dirtyChunks);
             }
         }
     }
 
     // Build meshes
-    for (auto& [coord, chunk] : chunks) {
+    for (Chunk* chunk : dirtyChunks) {
         chunk->buildMesh();
     }
 }
@@ -38,22 +90,32 @@ void World::updateChunksAroundPlayer(const glm::vec3& playerPos, int radius) {
     int playerChunkZ = static_cast<int>(std::floor(playerPos.z / Chunk::DEPTH));
 
     // Only update if player moved to a new chunk
-    if (playerChunkX != lastPlayerChunkX || playerChunkZ != lastPlayerChunkZ) {
+    if (playerChunkX != lastPlayerChunkX || playerChunkZ != lastPlayerChunkZ || radius != loadRadius) {
         lastPlayerChunkX = playerChunkX;
         lastPlayerChunkZ = playerChunkZ;
+        loadRadius = radius;
 
         // Unload chunks outside radius
         std::vector<std::pair<int, int>> toRemove;
-        for (const auto& [coord, chunk] : chunks) {
-            int dx = coord.first - playerChunkX;
-            int dz = coord.second - playerChunkZ;
+        for (const auto& slot : chunks.getSlots()) {
+            if (!slot.chunk) continue;
+            int dx = slot.x - playerChunkX;
+            int dz = slot.z - playerChunkZ;
             if (std::abs(dx) > radius || std::abs(dz) > radius) {
-                toRemove.push_back(coord);
+                toRemove.push_back({slot.x, slot.z});
             }
         }
         for (const auto& coord : toRemove) {
-            delete chunks[coord];
-            chunks.erase(coord);
+            delete chunks.remove(coord.first, coord.second);
+        }
+
+        // Render distance changed, what's left fits in the resized grid
+        if (radius != chunks.getRadius()) {
+            std::vector<Chunk*> evicted;
+            chunks.resize(radius, evicted);
+            for (Chunk* chunk : evicted) {
+                delete chunk;
+            }
         }
 
         chunkLoadQueue.clear();
@@ -63,7 +125,7 @@ void World::updateChunksAroundPlayer(const glm::vec3& playerPos, int radius) {
                 int cx = playerChunkX + x;
                 int cz = playerChunkZ + z;
                 std::pair<int, int> pos = {cx, cz};
-                if (chunks.find(pos) == chunks.end()) {
+                if (!getChunk(cx, cz) && chunksInFlight.find(pos) == chunksInFlight.end()) {
                     positions.push_back(pos);
                 }
             }
@@ -80,32 +142,310 @@ void World::updateChunksAroundPlayer(const glm::vec3& playerPos, int radius) {
         }
     }
 
-    if (!chunkLoadQueue.empty()) {
+    // Keep a few jobs per worker queued, so a player change of direction doesn't leave
+    // the pool busy with chunks that are already out of range
+    const size_t maxInFlight = jobs.getThreadCount() * 4;
+    while (!chunkLoadQueue.empty() && chunksInFlight.size() < maxInFlight) {
         auto pos = chunkLoadQueue.front();
         chunkLoadQueue.pop_front();
-        if (chunks.find(pos) == chunks.end()) {
-            Chunk* newChunk = new Chunk(pos.first, pos.second, this);
-            chunks[pos] = newChunk;
-            newChunk->buildMesh();
-            static const int dx[4] = {-1, 1, 0, 0};
-            static const int dz[4] = {0, 0, -1, 1};
-            for (int i = 0; i < 4; ++i) {
-                auto neighbor = getChunk(pos.first + dx[i], pos.second + dz[i]);
-                if (neighbor) neighbor->buildMesh();
+        chunksInFlight.insert(pos);
+        jobs.submit([this, pos]() {
+            generatedChunks.push(new Chunk(pos.first, pos.second, this));
+        });
+    }
+
+    integrateGeneratedChunks();
+    uploadFinishedMeshes();
+    applyFinishedSorts();
+    sortTranslucentSections(playerPos);
+}
+
+void World::integrateGeneratedChunks() {
+    std::vector<Chunk*> finished;
+    generatedChunks.popAll(finished);
+    if (finished.empty()) return;
+
+    std::set<Chunk*> dirtyChunks;
+    for (Chunk* chunk : finished) {
+        std::pair<int, int> pos = {chunk->chunkX, chunk->chunkZ};
+        chunksInFlight.erase(pos);
+
+        // Player moved away while it was generating
+        int dx = pos.first - lastPlayerChunkX;
+        int dz = pos.second - lastPlayerChunkZ;
+        if (std::abs(dx) > loadRadius || std::abs(dz) > loadRadius || getChunk(pos.first, pos.second)) {
+            delete chunk;
+            continue;
+        }
+        integrateChunk(chunk, dirtyChunks);
+    }
+
+    for (Chunk* chunk : dirtyChunks) {
+        requestMesh(chunk);
+    }
+}
+
+void World::requestMesh(Chunk* chunk) {
+    for (int sectionY = 0; sectionY < Chunk::SECTION_COUNT; ++sectionY) {
+        requestSectionMesh(chunk, sectionY);
+    }
+}
+
+void World::requestSectionMesh(Chunk* chunk, int sectionY) {
+    Chunk::SectionMesh& sectionMesh = chunk->meshes[sectionY];
+
+    // Empty sections have no faces, no need for a job
+    if (chunk->isSectionEmpty(sectionY)) {
+        sectionMesh.revision = nextMeshRevision();
+        chunk->clearMesh(sectionY);
+        return;
+    }
+
+    MeshJob* job = acquireMeshJob();
+    if (!chunk->takeSnapshot(sectionY, job->snapshot)) {
+        freeMeshJobs.push_back(job);
+        return;
+    }
+
+    job->mode = Chunk::meshingMode;
+    job->revision = sectionMesh.revision = nextMeshRevision();
+    meshesInFlight++;
+
+    // Two pointers fit in std::function's local storage, submitting doesn't allocate either
+    jobs.submit([this, job]() {
+        buildSectionMesh(job->snapshot, job->mode, job->mesh);
+        meshedChunks.push(job);
+    });
+}
+
+World::MeshJob* World::acquireMeshJob() {
+    if (freeMeshJobs.empty()) {
+        meshJobs.push_back(std::make_unique<MeshJob>());
+        meshJobs.back()->mesh.reserveTypical();
+        freeMeshJobs.reserve(meshJobs.size());
+        finishedMeshJobs.reserve(meshJobs.size());
+        // Every job of the pools could be queued on one worker at once
+        jobs.reserve(meshJobs.size() + sortJobs.size());
+        return meshJobs.back().get();
+    }
+    MeshJob* job = freeMeshJobs.back();
+    freeMeshJobs.pop_back();
+    return job;
+}
+
+void World::uploadFinishedMeshes() {
+    finishedMeshJobs.clear();
+    meshedChunks.popAll(finishedMeshJobs);
+
+    for (MeshJob* job : finishedMeshJobs) {
+        meshesInFlight--;
+
+        // Skip meshes of unloaded chunks and meshes a newer request replaced
+        Chunk* chunk = getChunk(job->snapshot.chunkX, job->snapshot.chunkZ);
+        int sectionY = job->snapshot.sectionY;
+        if (chunk && chunk->meshes[sectionY].revision == job->revision) {
+            chunk->uploadMesh(sectionY, job->mesh);
+        }
+        freeMeshJobs.push_back(job);
+    }
+}
+
+void World::sortTranslucentSections(const glm::vec3& cameraPos) {
+    const glm::ivec3 cameraBlock = glm::ivec3(glm::floor(cameraPos));
+
+    for (const auto& slot : chunks.getSlots()) {
+        Chunk* chunk = slot.chunk;
+        if (!chunk) continue;
+
+        for (int sectionY = 0; sectionY < Chunk::SECTION_COUNT; ++sectionY) {
+            Chunk::SectionMesh& mesh = chunk->meshes[sectionY];
+            if (mesh.translucentVertices.empty() || mesh.sortingRevision != 0) continue;
+
+            glm::vec3 center = getSectionCenter(chunk, sectionY);
+            if (mesh.sorted) {
+                if (glm::ivec3(glm::floor(mesh.sortedEye)) == cameraBlock) continue;
+                float moved = glm::distance(cameraPos, mesh.sortedEye);
+                if (moved < glm::distance(cameraPos, center) * SORT_DISTANCE_FRACTION) continue;
+            }
+
+            SortJob* job;
+            if (freeSortJobs.empty()) {
+                sortJobs.push_back(std::make_unique<SortJob>());
+                freeSortJobs.reserve(sortJobs.size());
+                finishedSortJobs.reserve(sortJobs.size());
+                jobs.reserve(meshJobs.size() + sortJobs.size());
+                job = sortJobs.back().get();
+            } else {
+                job = freeSortJobs.back();
+                freeSortJobs.pop_back();
+            }
+
+            // Any job can get any section, so jobs are kept at the size of the largest translucent
+            // mesh seen yet. Sized for their current section only, they would keep reallocating
+            // whenever they happen to get a bigger one.
+            sortJobVertices = std::max(sortJobVertices, mesh.translucentVertices.size());
+            if (job->vertices.capacity() < sortJobVertices) {
+                job->vertices.reserve(sortJobVertices);
+                job->sorted.reserve(sortJobVertices);
+                job->keys.reserve(sortJobVertices / 4);
             }
+            job->chunkX = chunk->chunkX;
+            job->chunkZ = chunk->chunkZ;
+            job->sectionY = sectionY;
+            job->revision = mesh.uploadedRevision;
+            job->cameraPos = cameraPos;
+            job->eye = cameraPos - (center - glm::vec3(ChunkSection::SIZE * 0.5f));
+            job->vertices.assign(mesh.translucentVertices.begin(), mesh.translucentVertices.end());
+            mesh.sortingRevision = mesh.uploadedRevision;
+            sortsInFlight++;
+
+            jobs.submit([this, job]() {
+                auto sortStart = std::chrono::steady_clock::now();
+                sortQuadsBackToFront(job->vertices, job->eye, job->keys, job->sorted);
+                job->sortMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+                sortedSections.push(job);
+            });
         }
     }
 }
 
-void World::render(const Camera& camera, GLint uModelLoc) {
-    for (auto& [coord, chunk] : chunks) {
-        chunk->render(camera, uModelLoc);
+void World::applyFinishedSorts() {
+    finishedSortJobs.clear();
+    sortedSections.popAll(finishedSortJobs);
+
+    auto uploadStart = std::chrono::steady_clock::now();
+    float sortMs = 0.0f;
+    for (SortJob* job : finishedSortJobs) {
+        sortsInFlight--;
+        sortMs += job->sortMs;
+
+        // Dropped if the chunk was unloaded or the section got a new mesh meanwhile, the new
+        // mesh is sorted next frame. Revisions are unique across reloads, so a stale job never
+        // releases the section for a newer sort still in flight.
+        Chunk* chunk = getChunk(job->chunkX, job->chunkZ);
+        if (chunk) {
+            Chunk::SectionMesh& mesh = chunk->meshes[job->sectionY];
+            if (mesh.sortingRevision == job->revision) mesh.sortingRevision = 0;
+            if (mesh.uploadedRevision == job->revision) {
+                chunk->updateTranslucentVertices(job->sectionY, job->sorted);
+                mesh.sorted = true;
+                mesh.sortedEye = job->cameraPos;
+            }
+        }
+        freeSortJobs.push_back(job);
+    }
+    float uploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+
+    // Smoothed, most frames don't sort anything
+    const float smoothing = 0.05f;
+    sortStats.frameMs += (sortMs + uploadMs - sortStats.frameMs) * smoothing;
+    sortStats.sectionsPerFrame += (static_cast<float>(finishedSortJobs.size()) - sortStats.sectionsPerFrame) * smoothing;
+}
+
+void World::integrateChunk(Chunk* chunk, std::set<Chunk*>& dirtyChunks) {
+    std::pair<int, int> pos = {chunk->chunkX, chunk->chunkZ};
+    if (!chunks.insert(chunk)) {
+        // Slot still held by another chunk, can only happen if it wasn't unloaded
+        delete chunk;
+        return;
+    }
+    dirtyChunks.insert(chunk);
+
+    static const int dx[4] = {0, 0, -1, 1}; // Same order as the faces
+    static const int dz[4] = {1, -1, 0, 0};
+    for (int face = 0; face < 4; ++face) {
+        chunk->linkNeighbor(face, getChunk(pos.first + dx[face], pos.second + dz[face]));
+    }
+
+    // Neighbours may now be able to build (or need to cull their border faces)
+    for (int face = 0; face < 4; ++face) {
+        Chunk* neighbor = chunk->getNeighbor(face);
+        if (neighbor) dirtyChunks.insert(neighbor);
+    }
+}
+
+void World::countDraws(int sections) {
+    drawStats.sections += sections;
+    if (sections != 0) drawStats.drawCalls++;
+}
+
+void World::render(const Camera& camera, Chunk::RenderPass pass) {
+    vertexArena.bind();
+
+    if (pass == Chunk::RenderPass::Opaque) {
+        drawStats = DrawStats(); // First pass of the frame
+        for (const auto& slot : chunks.getSlots()) {
+            if (slot.chunk) slot.chunk->queueDraws(pass);
+        }
+        countDraws(vertexArena.drawQueued());
+        glBindVertexArray(0);
+        return;
+    }
+
+    // Sections back to front, the quads inside each are sorted by sortTranslucentSections
+    const glm::vec3 cameraPos = camera.getPosition();
+    translucentDraws.clear();
+    for (const auto& slot : chunks.getSlots()) {
+        if (!slot.chunk) continue;
+        for (int sectionY = 0; sectionY < Chunk::SECTION_COUNT; ++sectionY) {
+            if (slot.chunk->meshes[sectionY].ranges[static_cast<int>(pass)] == VertexArena::INVALID_HANDLE) continue;
+            glm::vec3 offset = getSectionCenter(slot.chunk, sectionY) - cameraPos;
+            translucentDraws.push_back({glm::dot(offset, offset), slot.chunk, sectionY});
+        }
+    }
+    std::sort(translucentDraws.begin(), translucentDraws.end(),
+        [](const TranslucentDraw& a, const TranslucentDraw& b) { return a.distance > b.distance; });
+
+    // Multi-draws are drawn in order, so blending still goes back to front
+    for (const TranslucentDraw& draw : translucentDraws) {
+        draw.chunk->queueSectionDraw(draw.sectionY, pass);
+    }
+    countDraws(vertexArena.drawQueued());
+    glBindVertexArray(0);
+}
+
+void World::toggleMeshingMode() {
+    Chunk::meshingMode = (Chunk::meshingMode == Chunk::MeshingMode::Greedy)
+        ? Chunk::MeshingMode::PerFace : Chunk::MeshingMode::Greedy;
+    for (const auto& slot : chunks.getSlots()) {
+        if (slot.chunk) requestMesh(slot.chunk);
+    }
+}
+
+World::MeshStats World::getMeshStats() const {
+    MeshStats stats;
+    for (const auto& slot : chunks.getSlots()) {
+        if (!slot.chunk) continue;
+        for (const auto& mesh : slot.chunk->meshes) {
+            stats.vertexCount += mesh.vertexCount;
+            stats.totalMeshTimeMs += mesh.meshTimeMs;
+        }
+        stats.chunkCount++;
+    }
+    return stats;
+}
+
+World::GenerationStats World::getGenerationStats() const {
+    GenerationStats stats;
+    for (const auto& slot : chunks.getSlots()) {
+        if (!slot.chunk) continue;
+        const Chunk::GenerationTimes& times = slot.chunk->generationTimes;
+        stats.totalTimes.terrainMs += times.terrainMs;
+        stats.totalTimes.cavesMs += times.cavesMs;
+        stats.totalTimes.featuresMs += times.featuresMs;
+        stats.chunkCount++;
+    }
+    return stats;
+}
+
+size_t World::getBlockMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& slot : chunks.getSlots()) {
+        if (slot.chunk) bytes += slot.chunk->getMemoryUsage();
     }
+    return bytes;
 }
 
 Chunk* World::getChunk(int x, int z) const {
-    auto it = chunks.find({x, z});
-    if (it != chunks.end())
-        return it->second;
-    return nullptr;
+    return chunks.get(x, z);
 }
@@ -1,8 +1,14 @@
 #pragma once
 
-#include <map>
+#include <memory>
+#include <set>
 #include <utility>
 #include "chunk.hpp"
+#include "chunkGrid.hpp"
+#include "noise.hpp"
+#include "terrainColumnCache.hpp"
+#include "../core/jobSystem.hpp"
+#include "../core/lockFreeQueue.hpp"
 
 class Chunk;
 
@@ -12,14 +18,113 @@ public:
     ~World();
 
     Chunk* getChunk(int x, int z) const;
+    const GeneratorContext& getGenerator() const { return generator; }
+    TerrainColumnCache& getColumnCache() { return columnCache; }
+    // Vertices of every chunk mesh, GL thread only
+    VertexArena& getVertexArena() { return vertexArena; }
 
     void generateChunks(int radius);
-    void render(const Camera& camera, GLint uModelLoc);
+    // One multi-draw per pass, the translucent pass draws sections from the farthest to the nearest
+    void render(const Camera& camera, Chunk::RenderPass pass);
 
     void updateChunksAroundPlayer(const glm::vec3& playerPos, int radius);
 
+    // Switches between greedy and per-face meshing and rebuilds every loaded chunk
+    void toggleMeshingMode();
+
+    struct MeshStats {
+        size_t vertexCount = 0;
+        float totalMeshTimeMs = 0.0f;
+        int chunkCount = 0;
+    };
+    MeshStats getMeshStats() const;
+
+    // Generation stage times summed over the loaded chunks
+    struct GenerationStats {
+        Chunk::GenerationTimes totalTimes;
+        int chunkCount = 0;
+    };
+    GenerationStats getGenerationStats() const;
+
+    // Cost of re-sorting translucent geometry (worker sort plus index upload), averaged over recent frames
+    struct SortStats {
+        float frameMs = 0.0f;
+        float sectionsPerFrame = 0.0f;
+    };
+    SortStats getSortStats() const { return sortStats; }
+
+    // Sections drawn by the last frame's passes and the draw calls they took
+    struct DrawStats {
+        int sections = 0;
+        int drawCalls = 0;
+    };
+    DrawStats getDrawStats() const { return drawStats; }
+
+    // Bytes used by the block storage of every loaded chunk
+    size_t getBlockMemoryUsage() const;
+
+    // Snapshots the chunk's sections and meshes them on workers, the results are uploaded by updateChunksAroundPlayer
+    void requestMesh(Chunk* chunk);
+    void requestSectionMesh(Chunk* chunk, int sectionY);
+    uint64_t nextMeshRevision() { return ++meshRevisionCounter; }
+
+    int getChunksInFlight() const { return static_cast<int>(chunksInFlight.size()); }
+    int getMeshesInFlight() const { return meshesInFlight; }
+    int getSortsInFlight() const { return sortsInFlight; }
+
 private:
-    std::map<std::pair<int, int>, Chunk*> chunks;
+    ChunkGrid chunks;
     int lastPlayerChunkX = INT32_MIN;
     int lastPlayerChunkZ = INT32_MIN;
+    int loadRadius = 0;
+
+    // Shared by all generation jobs, must outlive them
+    const GeneratorContext generator;
+    TerrainColumnCache columnCache;
+
+    // Must outlive the chunks, they free their ranges when deleted
+    VertexArena vertexArena;
+
+    // Chunk generation runs on the job system, finished chunks come back through generatedChunks
+    JobSystem jobs;
+    LockFreeQueue<Chunk*> generatedChunks;
+    std::set<std::pair<int, int>> chunksInFlight;
+
+    // Meshing jobs, finished meshes come back through meshedChunks. Jobs are pooled and keep
+    // their snapshot and mesh buffers, so a rebuild doesn't allocate once the pool is warm.
+    struct MeshJob;
+    IntrusiveLockFreeQueue<MeshJob> meshedChunks;
+    std::vector<std::unique_ptr<MeshJob>> meshJobs; // Owns every job, in flight or free
+    std::vector<MeshJob*> freeMeshJobs;
+    std::vector<MeshJob*> finishedMeshJobs; // Reused by uploadFinishedMeshes
+    uint64_t meshRevisionCounter = 0;
+    int meshesInFlight = 0;
+
+    // Translucent vertex ranges are re-sorted back to front on workers as the camera moves,
+    // sorted sections come back through sortedSections. Pooled like the meshing jobs.
+    struct SortJob;
+    IntrusiveLockFreeQueue<SortJob> sortedSections;
+    std::vector<std::unique_ptr<SortJob>> sortJobs;
+    std::vector<SortJob*> freeSortJobs;
+    std::vector<SortJob*> finishedSortJobs;
+    size_t sortJobVertices = 0; // Largest translucent mesh sorted yet, every job is grown to it
+    int sortsInFlight = 0;
+    SortStats sortStats;
+    DrawStats drawStats;
+    void countDraws(int sections);
+
+    // Translucent sections of the frame, drawn back to front
+    struct TranslucentDraw {
+        float distance;
+        Chunk* chunk;
+        int sectionY;
+    };
+    std::vector<TranslucentDraw> translucentDraws;
+
+    void integrateChunk(Chunk* chunk, std::set<Chunk*>& dirtyChunks);
+    void integrateGeneratedChunks();
+    void uploadFinishedMeshes();
+    MeshJob* acquireMeshJob();
+    void sortTranslucentSections(const glm::vec3& cameraPos);
+    void applyFinishedSorts();
 };
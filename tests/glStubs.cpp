@@ -0,0 +1,48 @@
+#include <glad/glad.h>
+#include "glStubs.hpp"
+
+static GLuint nextName = 1;
+static GLint maxTextureBufferSize = 65536; // The GL 3.3 minimum
+
+static void APIENTRY genNames(GLsizei n, GLuint* names) {
+    for (GLsizei i = 0; i < n; ++i) names[i] = nextName++;
+}
+static void APIENTRY deleteNames(GLsizei, const GLuint*) {}
+static void APIENTRY bindName(GLenum, GLuint) {}
+static void APIENTRY bindVertexArray(GLuint) {}
+static void APIENTRY activeTexture(GLenum) {}
+static void APIENTRY enableVertexAttribArray(GLuint) {}
+static void APIENTRY vertexAttribIPointer(GLuint, GLint, GLenum, GLsizei, const void*) {}
+static void APIENTRY bufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+static void APIENTRY bufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+static void APIENTRY copyBufferSubData(GLenum, GLenum, GLintptr, GLintptr, GLsizeiptr) {}
+static void APIENTRY texBuffer(GLenum, GLenum, GLuint) {}
+static void APIENTRY getIntegerv(GLenum name, GLint* data) {
+    *data = name == GL_MAX_TEXTURE_BUFFER_SIZE ? maxTextureBufferSize : 0;
+}
+static void APIENTRY multiDrawElementsBaseVertex(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei, const GLint*) {}
+
+void stubGLFunctions() {
+    glad_glGenBuffers = genNames;
+    glad_glGenTextures = genNames;
+    glad_glGenVertexArrays = genNames;
+    glad_glDeleteBuffers = deleteNames;
+    glad_glDeleteTextures = deleteNames;
+    glad_glDeleteVertexArrays = deleteNames;
+    glad_glBindBuffer = bindName;
+    glad_glBindTexture = bindName;
+    glad_glBindVertexArray = bindVertexArray;
+    glad_glActiveTexture = activeTexture;
+    glad_glEnableVertexAttribArray = enableVertexAttribArray;
+    glad_glVertexAttribIPointer = vertexAttribIPointer;
+    glad_glBufferData = bufferData;
+    glad_glBufferSubData = bufferSubData;
+    glad_glCopyBufferSubData = copyBufferSubData;
+    glad_glTexBuffer = texBuffer;
+    glad_glMultiDrawElementsBaseVertex = multiDrawElementsBaseVertex;
+    glad_glGetIntegerv = getIntegerv;
+}
+
+void setStubMaxTextureBufferSize(int texels) {
+    maxTextureBufferSize = texels;
+}
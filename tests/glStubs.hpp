@@ -0,0 +1,8 @@
+#pragma once
+
+// Points the glad functions World, Chunk and VertexArena call at stand-ins that do nothing
+// (generated object names just count up), so chunks can be meshed and "uploaded" without a
+// window or GL context
+void stubGLFunctions();
+// What glGetIntegerv reports for GL_MAX_TEXTURE_BUFFER_SIZE, 65536 unless set
+void setStubMaxTextureBufferSize(int texels);
@@ -0,0 +1,251 @@
+// Meshing of generated terrain, without a window (GL calls go to glStubs):
+//  - Face culling: both meshers against a brute force rule that looks at each face's
+//    neighbour, exactly for per-face meshing and as the faces the quads cover for greedy meshing
+//  - Steady state allocations: once the scratch buffers and job pools are warm, remeshing
+//    every chunk on the synchronous and on the worker path (translucent sorts included)
+//    allocates nothing
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "glStubs.hpp"
+#include "../src/core/options.hpp"
+#include "../src/world/blockDB.hpp"
+#include "../src/world/chunkMesher.hpp"
+#include "../src/world/structureDB.hpp"
+#include "../src/world/world.hpp"
+
+static const int SEED = 1234;
+static const int RADIUS = 4; // The inner 7x7 chunks have all their neighbours
+
+static int failures = 0;
+
+// Every allocation of the process, worker threads included
+static std::atomic<size_t> allocationCount(0);
+
+static void* countedAllocate(std::size_t size) {
+    allocationCount++;
+    if (void* memory = std::malloc(size != 0 ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+// One visible block face, the unit a merged quad covers width x height of
+struct Face {
+    int x, y, z, face, tile;
+    bool translucent; // Pass
+
+    bool operator<(const Face& other) const {
+        return std::tie(x, y, z, face, tile, translucent) < std::tie(other.x, other.y, other.z, other.face, other.tile, other.translucent);
+    }
+    bool operator==(const Face& other) const {
+        return std::tie(x, y, z, face, tile, translucent) == std::tie(other.x, other.y, other.z, other.face, other.tile, other.translucent);
+    }
+};
+
+static bool isOpaque(uint8_t type) {
+    const BlockDB::BlockInfo* info = BlockDB::getBlockInfo(type);
+    return info && !info->transparent;
+}
+
+// A face shows unless its neighbour is opaque, or the block is transparent and the neighbour the same block.
+// Blended blocks go to the translucent pass, cutout ones to the opaque pass.
+static void getExpectedFaces(const SectionSnapshot& snapshot, std::vector<Face>& faces) {
+    static const int offsets[6][3] = {{0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+
+    faces.clear();
+    for (int y = 0; y < SectionSnapshot::SIZE; ++y) {
+        for (int z = 0; z < SectionSnapshot::SIZE; ++z) {
+            for (int x = 0; x < SectionSnapshot::SIZE; ++x) {
+                uint8_t type = snapshot.get(x, y, z);
+                const BlockDB::BlockInfo* info = BlockDB::getBlockInfo(type);
+                if (!info) continue;
+
+                for (int face = 0; face < 6; ++face) {
+                    uint8_t neighbor = snapshot.get(x + offsets[face][0], y + offsets[face][1], z + offsets[face][2]);
+                    if (isOpaque(neighbor)) continue;
+                    if (info->transparent && neighbor == type) continue;
+
+                    const glm::vec2& tile = info->textureCoords[face];
+                    faces.push_back({x, y, z, face, static_cast<int>(tile.y) * 16 + static_cast<int>(tile.x), info->isBlended()});
+                }
+            }
+        }
+    }
+    std::sort(faces.begin(), faces.end());
+}
+
+// Unit faces covered by a pass's quads, false if a quad is malformed
+static bool getMeshFaces(const std::vector<PackedVertex>& vertices, bool translucent, bool unitQuads, std::vector<Face>& faces) {
+    // Corner positions of a unit quad per face (as chunkMesher's addFace), and the axes width and height run along
+    static const int corner0[6][3] = {{0, 0, 1}, {1, 0, 0}, {0, 0, 0}, {1, 0, 1}, {0, 1, 1}, {0, 0, 0}};
+    static const int uAxis[6] = {0, 0, 2, 2, 0, 0};
+    static const int vAxis[6] = {1, 1, 1, 1, 2, 2};
+
+    if (vertices.size() % 4 != 0) return false;
+    for (size_t quad = 0; quad < vertices.size(); quad += 4) {
+        const PackedVertex* corners = &vertices[quad];
+        const PackedVertex& first = corners[0];
+        int face = first.getFace();
+        int width = first.getWidth();
+        int height = first.getHeight();
+        if (face > 5 || width < 1 || height < 1 || first.getCorner() != 0) return false;
+        if (unitQuads && (width != 1 || height != 1)) return false;
+        for (int i = 1; i < 4; ++i) {
+            if (corners[i].getFace() != face || corners[i].getTile() != first.getTile() || corners[i].getCorner() != i ||
+                corners[i].getWidth() != width || corners[i].getHeight() != height) return false;
+        }
+
+        int size[3] = {1, 1, 1};
+        size[uAxis[face]] = width;
+        size[vAxis[face]] = height;
+        int origin[3] = {first.getX() - corner0[face][0] * size[0], first.getY() - corner0[face][1] * size[1],
+                         first.getZ() - corner0[face][2] * size[2]};
+        for (int v = 0; v < height; ++v) {
+            for (int u = 0; u < width; ++u) {
+                int pos[3] = {origin[0], origin[1], origin[2]};
+                pos[uAxis[face]] += u;
+                pos[vAxis[face]] += v;
+                faces.push_back({pos[0], pos[1], pos[2], face, first.getTile(), translucent});
+            }
+        }
+    }
+    return true;
+}
+
+static bool checkSection(const SectionSnapshot& snapshot, const char* source) {
+    std::vector<Face> expected, actual;
+    getExpectedFaces(snapshot, expected);
+
+    const Chunk::MeshingMode modes[2] = {Chunk::MeshingMode::PerFace, Chunk::MeshingMode::Greedy};
+    SectionMeshData mesh;
+    for (Chunk::MeshingMode mode : modes) {
+        bool perFace = mode == Chunk::MeshingMode::PerFace;
+        buildSectionMesh(snapshot, mode, mesh);
+
+        actual.clear();
+        bool wellFormed = getMeshFaces(mesh.opaque, false, perFace, actual) && getMeshFaces(mesh.translucent, true, perFace, actual);
+        std::sort(actual.begin(), actual.end());
+        // Sorted with duplicates kept, a face covered twice doesn't match
+        if (!wellFormed || actual != expected || mesh.vertexCount != mesh.opaque.size() + mesh.translucent.size()) {
+            std::printf("FAIL %s section (%d, %d, %d), %s meshing: %s, %zu faces expected, %zu meshed\n",
+                        source, snapshot.chunkX, snapshot.sectionY, snapshot.chunkZ, perFace ? "per-face" : "greedy",
+                        wellFormed ? "different faces" : "malformed quad", expected.size(), actual.size());
+            failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkFaceCulling(World& world) {
+    int generated = 0;
+    SectionSnapshot snapshot;
+    for (int x = -RADIUS + 1; x <= RADIUS - 1; ++x) {
+        for (int z = -RADIUS + 1; z <= RADIUS - 1; ++z) {
+            Chunk* chunk = world.getChunk(x, z);
+            for (int sectionY = 0; sectionY < Chunk::SECTION_COUNT; ++sectionY) {
+                if (chunk->isSectionEmpty(sectionY) || !chunk->takeSnapshot(sectionY, snapshot)) continue;
+                checkSection(snapshot, "generated");
+                generated++;
+            }
+        }
+    }
+
+    // Random blocks meet every pair of block types, including transparent ones of different kinds
+    const uint8_t types[] = {0, 0, 0, 1, 2, 3, 5, 8, 9, 9, 10, 11, 11, 12};
+    const int typeCount = sizeof(types) / sizeof(types[0]);
+    unsigned int state = SEED;
+    const int randomSections = 200;
+    for (int i = 0; i < randomSections; ++i) {
+        snapshot.chunkX = i;
+        snapshot.chunkZ = 0;
+        snapshot.sectionY = 0;
+        snapshot.topY = SectionSnapshot::SIZE - 1;
+        // Some sections are only a few types, so large same-tile areas get merged
+        int variety = 2 + i % (typeCount - 1);
+        for (uint8_t& block : snapshot.blocks) {
+            state = state * 1664525u + 1013904223u;
+            block = types[(state >> 16) % variety];
+        }
+        checkSection(snapshot, "random");
+    }
+
+    std::printf("Face culling: %d generated and %d random sections checked\n", generated, randomSections);
+}
+
+// Pumps the world until the workers finished every mesh and sort in flight and their results are uploaded
+static void settle(World& world, const glm::vec3& cameraPos) {
+    do {
+        std::this_thread::yield();
+        world.updateChunksAroundPlayer(cameraPos, RADIUS);
+    } while (world.getMeshesInFlight() != 0 || world.getSortsInFlight() != 0);
+}
+
+static void checkSteadyStateAllocations(World& world) {
+    const int ROUNDS = 4;
+    // In the same chunk, far enough apart that switching re-sorts every translucent section
+    const glm::vec3 cameras[2] = {glm::vec3(2.5f, 60.0f, 2.5f), glm::vec3(13.5f, 110.0f, 13.5f)};
+
+    std::vector<Chunk*> chunks;
+    for (int x = -RADIUS; x <= RADIUS; ++x) {
+        for (int z = -RADIUS; z <= RADIUS; ++z) {
+            chunks.push_back(world.getChunk(x, z));
+        }
+    }
+
+    // Warm up. Requesting every mesh and moving the camera in the same frame queues the most
+    // meshing and sorting jobs there can be at once, so the pools (and the worker queues reserved
+    // along with them) reach full size.
+    settle(world, cameras[0]);
+    for (int round = 0; round < 2; ++round) {
+        for (Chunk* chunk : chunks) chunk->buildMesh();
+        for (Chunk* chunk : chunks) world.requestMesh(chunk);
+        settle(world, cameras[(round + 1) % 2]);
+    }
+
+    size_t before = allocationCount;
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (Chunk* chunk : chunks) chunk->buildMesh();
+    }
+    size_t synchronous = allocationCount - before;
+
+    before = allocationCount;
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (Chunk* chunk : chunks) world.requestMesh(chunk);
+        settle(world, cameras[round % 2]);
+    }
+    size_t workers = allocationCount - before;
+
+    std::printf("Steady state allocations over %d remeshes of %zu chunks: %zu synchronous, %zu on workers\n",
+                ROUNDS, chunks.size(), synchronous, workers);
+    if (synchronous != 0 || workers != 0) {
+        std::printf("FAIL remeshing allocates once warmed up\n");
+        failures++;
+    }
+}
+
+int main() {
+    stubGLFunctions();
+    BlockDB::initialize();
+    StructureDB::initialize();
+
+    setOptionInt("world_seed", SEED);
+    World world;
+    world.generateChunks(RADIUS);
+
+    checkFaceCulling(world);
+    checkSteadyStateAllocations(world);
+
+    return failures == 0 ? 0 : 1;
+}
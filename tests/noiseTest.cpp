@@ -0,0 +1,108 @@
+// SSE2 and AVX2 noise batches (2D, and 3D for the cave noise) against FastNoiseLite, bit for bit. Terrain must come out the
+// same whichever kernels a machine picks, so any difference fails the test. Also fails if a
+// kernel gets rejected by BatchNoise::useSimd's startup check (which falls back to scalar).
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "../src/world/noise.hpp"
+
+static int failures = 0;
+
+// Points like generation uses them (whole block coordinates around the origin, fractional
+// distorted ones) plus far and negative ones. Odd count so the batch ends on a partial vector.
+static void makePoints(unsigned int seed, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z) {
+    const int count = 8191;
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    unsigned int state = seed * 2654435761u + 1;
+    for (int i = 0; i < count; ++i) {
+        state = state * 1664525u + 1013904223u;
+        float u = static_cast<int>(state >> 8 & 0xffff) / 65535.0f * 2.0f - 1.0f;
+        state = state * 1664525u + 1013904223u;
+        float v = static_cast<int>(state >> 8 & 0xffff) / 65535.0f * 2.0f - 1.0f;
+
+        state = state * 1664525u + 1013904223u;
+        float w = static_cast<int>(state >> 8 & 0xffff) / 65535.0f * 2.0f - 1.0f;
+
+        switch (i % 4) {
+            case 0: x[i] = static_cast<float>(i % 181 - 90); y[i] = static_cast<float>(i / 181 - 22); z[i] = static_cast<float>(i % 128 * 2); break;
+            case 1: x[i] = u * 512.0f; y[i] = v * 512.0f; z[i] = w * 512.0f; break;
+            case 2: x[i] = u * 30000.0f; y[i] = v * 30000.0f; z[i] = w * 300.0f; break;
+            default: x[i] = static_cast<float>(static_cast<int>(u * 1000000.0f)); y[i] = v * 1000000.0f; z[i] = w * 1000000.0f; break;
+        }
+    }
+}
+
+// z is null for 2D noise
+static bool matchesScalar(const char* name, const BatchNoise& noise, NoiseSimd simd, int seed,
+                          const float* x, const float* y, const float* z, const float* batch, int count) {
+    for (int i = 0; i < count; ++i) {
+        float expected = z ? noise.getNoise(x[i], y[i], z[i]) : noise.getNoise(x[i], y[i]); // FastNoiseLite
+        if (std::memcmp(&batch[i], &expected, sizeof(float)) != 0) {
+            std::cerr << "FAIL " << name << " seed " << seed << " " << getNoiseSimdName(simd)
+                      << ": noise(" << x[i] << ", " << y[i];
+            if (z) std::cerr << ", " << z[i];
+            std::cerr << ") = " << batch[i]
+                      << ", FastNoiseLite gives " << expected << " (batch of " << count << ")" << std::endl;
+            failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void getBatch(const BatchNoise& noise, const float* x, const float* y, const float* z, float* out, int count) {
+    if (z) noise.getNoise(x, y, z, out, count);
+    else noise.getNoise(x, y, out, count);
+}
+
+static void checkNoise(const char* name, const BatchNoise& noise, NoiseSimd simd, int seed, bool threeD = false) {
+    if (noise.getSimd() != simd) {
+        std::cerr << "FAIL " << name << " seed " << seed << ": " << getNoiseSimdName(simd)
+                  << " kernel rejected, batches run " << getNoiseSimdName(noise.getSimd()) << std::endl;
+        failures++;
+        return;
+    }
+
+    std::vector<float> x, y, z;
+    makePoints(static_cast<unsigned int>(seed), x, y, z);
+    int count = static_cast<int>(x.size());
+
+    // The whole set at once, then every batch length up to two AVX2 vectors at shifting offsets
+    std::vector<float> batch(count);
+    const float* zs = threeD ? z.data() : nullptr;
+    getBatch(noise, x.data(), y.data(), zs, batch.data(), count);
+    if (!matchesScalar(name, noise, simd, seed, x.data(), y.data(), zs, batch.data(), count)) return;
+    for (int length = 1; length <= 16; ++length) {
+        int start = length * 37;
+        const float* zStart = zs ? zs + start : nullptr;
+        getBatch(noise, x.data() + start, y.data() + start, zStart, batch.data(), length);
+        if (!matchesScalar(name, noise, simd, seed, x.data() + start, y.data() + start, zStart, batch.data(), length)) return;
+    }
+}
+
+int main() {
+    const int seeds[] = {1234, 0, -1, 42, 987654321, -2147483647};
+    const NoiseSimd levels[] = {NoiseSimd::SSE2, NoiseSimd::AVX2};
+    NoiseSimd supported = detectNoiseSimd();
+
+    for (NoiseSimd simd : levels) {
+        if (static_cast<int>(simd) > static_cast<int>(supported)) {
+            std::cout << "Skipping " << getNoiseSimdName(simd) << ", not supported by this CPU" << std::endl;
+            continue;
+        }
+        for (int seed : seeds) {
+            ChunkNoises noises = noiseInit(seed, simd);
+            checkNoise("biomeNoise", noises.biomeNoise, simd, seed);
+            checkNoise("biomeDistortNoise", noises.biomeDistortNoise, simd, seed);
+            checkNoise("baseNoise", noises.baseNoise, simd, seed);
+            checkNoise("detailNoise", noises.detailNoise, simd, seed);
+            checkNoise("detail2Noise", noises.detail2Noise, simd, seed);
+            checkNoise("caveNoise", noises.caveNoise, simd, seed, true);
+        }
+        std::cout << getNoiseSimdName(simd) << " checked on " << sizeof(seeds) / sizeof(seeds[0]) << " seeds" << std::endl;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// VertexArena without a window (GL calls go to glStubs), with a small GL_MAX_TEXTURE_BUFFER_SIZE:
+//  - The arena takes its capacity limit from the page table limit and never grows past it
+//  - Allocating into a full arena fails with INVALID_HANDLE, and works again once ranges are freed
+#include <cstdio>
+#include <vector>
+#include "glStubs.hpp"
+#include "../src/renderer/vertexArena.hpp"
+#include "../src/world/chunkMesher.hpp"
+
+static const int MAX_TEXELS = 48; // Pages, not a power of two so doubling the capacity overshoots it
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+int main() {
+    stubGLFunctions();
+    setStubMaxTextureBufferSize(MAX_TEXELS);
+    const uint32_t maxVertices = MAX_TEXELS * VertexArena::PAGE_SIZE;
+
+    // Two pages a range, starting above the limit
+    std::vector<PackedVertex> vertices(VertexArena::PAGE_SIZE * 2, PackedVertex::pack(0, 0, 0, 0, 0, 0, 1, 1));
+    const uint32_t count = static_cast<uint32_t>(vertices.size());
+    VertexArena arena(maxVertices * 4);
+
+    std::vector<uint32_t> handles;
+    for (int i = 0; i < MAX_TEXELS / 2; ++i) {
+        handles.push_back(arena.allocate(vertices.data(), count, glm::ivec3(i, 0, 0)));
+        check(handles.back() != VertexArena::INVALID_HANDLE, "allocation below the limit failed");
+    }
+    VertexArena::Stats stats = arena.getStats();
+    check(stats.maxCapacity == maxVertices, "max capacity doesn't follow GL_MAX_TEXTURE_BUFFER_SIZE");
+    check(stats.capacity <= maxVertices, "initial capacity above the limit");
+    check(stats.used == maxVertices, "arena not full");
+
+    check(arena.allocate(vertices.data(), count, glm::ivec3(0)) == VertexArena::INVALID_HANDLE,
+          "allocation into the full arena succeeded");
+    check(arena.getStats().capacity <= maxVertices, "arena grew past the limit");
+
+    // Every other range freed, the holes fit a range again
+    for (size_t i = 0; i < handles.size(); i += 2) arena.free(handles[i]);
+    check(arena.allocate(vertices.data(), count, glm::ivec3(0)) != VertexArena::INVALID_HANDLE,
+          "allocation after freeing failed");
+
+    // Growing from a small arena stops at the limit too
+    VertexArena growing(VertexArena::PAGE_SIZE * 2);
+    uint32_t allocated = 0;
+    while (growing.allocate(vertices.data(), count, glm::ivec3(0)) != VertexArena::INVALID_HANDLE) allocated += count;
+    stats = growing.getStats();
+    check(stats.capacity == maxVertices && allocated == maxVertices, "growing arena didn't fill up to the limit");
+
+    std::printf("Vertex arena limit: %u vertices, %d growths to reach it\n", maxVertices, stats.growths);
+    return failures == 0 ? 0 : 1;
+}